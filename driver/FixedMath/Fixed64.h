@@ -530,6 +530,32 @@ static FP_LONG FP64_DivFastest(FP_LONG a, FP_LONG b) {
     return ShiftRight(sign * y, offset);
 }
 
+/// <summary>
+/// Calculates division approximation without a hardware divide (RcpLerp32Newton(), about 23.7 bits).
+/// </summary>
+static FP_LONG FP64_DivNewton(FP_LONG a, FP_LONG b) {
+    if (b == MinValue || b == 0) {
+        InvalidArgument("Fixed64::DivNewton", "b", b);
+        return 0;
+    }
+
+    // Handle negative values.
+    FP_INT negative = b < 0;
+    if (negative)
+        b = -b;
+
+    // Normalize input into [1.0, 2.0( range (convert to s2.30).
+    // ShiftRightL(), because ShiftRight() would truncate b to 32 bits first.
+    FP_INT offset = 31 - FP64_Nlz((FP_ULONG) b);
+    FP_INT n = (FP_INT) ShiftRightL(b, offset + 2);
+
+    FP_INT res = RcpLerp32Newton(n);
+
+    // Apply exponent, convert back to s32.32.
+    FP_LONG y = ShiftRightL(FP64_MulIntLongLong(res, a) << 2, offset);
+    return negative ? -y : y;
+}
+
 /// <summary>
 /// Divides two FP values and returns the modulus.
 /// </summary>
@@ -211,6 +211,27 @@
         return y;
     }
 
+    // 1 / (1 + i / 32) in s2.30, i = 0..32
+    static const FP_INT RcpLerp32Table[] =
+    {
+        1073741824, 1041204193, 1010580540, 981706811, 954437177, 928641578, 904203641, 881018933,
+        858993459, 838042399, 818089009, 799063683, 780903145, 763549742, 746950834, 731058263,
+        715827883, 701219150, 687194767, 673720360, 660764199, 648296950, 636291451, 624722516,
+        613566757, 602802428, 592409282, 582368447, 572662306, 563274399, 554189329, 545392673,
+        536870912,
+    };
+
+    // Reciprocal of n in [1.0, 2.0( (s2.30): a chord of the table (about 12 bits), then one Newton-Raphson step
+    // Precision: 23.7 bits
+    static FP_INT RcpLerp32Newton(FP_INT n)
+    {
+        FP_INT a = n - (1 << 30);
+        FP_INT i = a >> 25;
+        FP_INT y = RcpLerp32Table[i] - (FP_INT)((FP_LONG)(RcpLerp32Table[i] - RcpLerp32Table[i + 1]) * (a & 0x1ffffff) >> 25);
+        FP_LONG e = (2ll << 30) - ((FP_LONG)n * y >> 30);
+        return (FP_INT)((FP_LONG)y * e >> 30);
+    }
+
     // Sqrt()
 
     // Precision: 13.36 bits
@@ -7,50 +7,87 @@
 #include <linux/module.h>
 #include <linux/time.h>
 #include <linux/string.h>   //strlen
+#include <linux/slab.h>
+#include <linux/mm.h>      // kvzalloc
+#include <linux/mutex.h>
+#include <linux/sched.h>   // cond_resched
+#include <linux/rcupdate.h>
+#include <linux/jump_label.h>
+#include <linux/math64.h>
+#include <linux/version.h>
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 10, 0))
+#include <linux/static_call.h>
+#endif
 #include "FixedMath/Fixed64.h"
 #include "../shared_definitions.h"
 #include "accel_modes.h"
+#include "motion_ring.h"
+#include "health.h"
+
+#define CREATE_TRACE_POINTS
+#include "yeetmouse_trace.h"
 
 MODULE_AUTHOR("Christopher Williams <chilliams (at) gmail (dot) com>"); //Original idea of this module
 MODULE_AUTHOR("Klaus Zipfel <klaus (at) zipfel (dot) family>");         //Current maintainer
 MODULE_AUTHOR("Maciej Grzęda <gmaciejg525 (at) gmail (dot) com>");      // Current maintainer
 // Sorry if you have issues with compilation because of this silly character in my family name lol <3
 
+#ifndef USE_CURVE_TABLE
+#define USE_CURVE_TABLE 0 // Older "config.h" files don't have it
+#endif
+
+#ifndef LUT_INTERPOLATION
+#define LUT_INTERPOLATION LutInterp_Linear
+#endif
+
 //Converts a preprocessor define's value in "config.h" to a string - Suspect this to change in future version without a "config.h"
 #define _s(x) #x
 #define s(x) _s(x)
 
-//Convenient helper for float based parameters, which are passed via a string to this module (must be individually parsed via atof() - available in util.c)
-#define PARAM_F(param, default, desc)                           \
-    FP_LONG g_##param = C0NST_FP64_FromDouble(default);                     \
-    char* g_param_##param = s(default);                  \
-    module_param_named(param, g_param_##param, charp, 0644);    \
+// Length of the text parameters below. The driver writes them back after a binary commit, so they are buffers of their own
+#define PARAM_TEXT_LEN 32
+
+//Convenient helper for float based parameters, which are passed via a string to this module (parsed with FP64_FromString() on commit)
+#define PARAM_F(param, default, desc)                                       \
+    static char g_param_##param[PARAM_TEXT_LEN] = s(default);               \
+    module_param_string(param, g_param_##param, PARAM_TEXT_LEN, 0644);      \
     MODULE_PARM_DESC(param, desc);
 
 #define PARAM(param, default, desc)                             \
-    char g_##param = default;                            \
+    static char g_##param = default;                            \
     module_param_named(param, g_##param, byte, 0644);           \
     MODULE_PARM_DESC(param, desc);
 
-#define PARAM_ARR(param, default, desc) \
-    char g_param_##param[MAX_LUT_BUF_LEN] = s(default);                            \
-    module_param_string(param, g_param_##param, MAX_LUT_BUF_LEN, 0644);           \
+#define PARAM_UL(param, default, desc)                                      \
+    static char g_param_##param[PARAM_TEXT_LEN] = s(default);               \
+    module_param_string(param, g_param_##param, PARAM_TEXT_LEN, 0644);      \
     MODULE_PARM_DESC(param, desc);
 
-#define PARAM_UL(param, default, desc)                           \
-    unsigned long g_##param = (unsigned long)default;                     \
-    char* g_param_##param = s(default);                            \
-    module_param_named(param, g_##param, ulong, 0644);           \
-    MODULE_PARM_DESC(param, desc);
+static int update_set(const char *val, const struct kernel_param *kp);
+static int lut_data_set(const char *val, const struct kernel_param *kp);
+static int lut_data_get(char *buffer, const struct kernel_param *kp);
+
+static const struct kernel_param_ops update_ops = {
+    .set = update_set,
+    .get = param_get_byte,
+};
+
+static const struct kernel_param_ops lut_data_ops = {
+    .set = lut_data_set,
+    .get = lut_data_get,
+};
 
 // ########## Kernel module parameters
 
-// Simple module parameters (instant update)
+// Writing a non-zero value to "update" commits all the parameters below at once
+static char g_update = 0;
+module_param_cb(update, &update_ops, &g_update, 0644);
+MODULE_PARM_DESC(update, "Triggers an update of the acceleration parameters below");
+
 //PARAM(no_bind,          0,                  "This will disable binding to this driver via 'yeetmouse_bind' by udev.");
-PARAM(update,           1,                  "Triggers an update of the acceleration parameters below");
 PARAM(AccelerationMode, ACCELERATION_MODE,  "Sets the algorithm to be used for acceleration");
 
-// Acceleration parameters (type pchar. Converted to float via "update_params" triggered by /sys/module/yeetmouse/parameters/update)
+// Acceleration parameters (type pchar. Parsed and published by a write to /sys/module/yeetmouse/parameters/update)
 PARAM_F(InputCap,       INPUT_CAP,          "Limit the maximum pointer speed before applying acceleration.");
 PARAM_F(Sensitivity,    SENSITIVITY,        "Mouse base sensitivity, or X axis sensitivity if the anisotropy is on."); // Sensitivity for X axis only if sens != sens_y (anisotropy is on), otherwise sensitivity for both axes
 PARAM_F(SensitivityY,   SENSITIVITY_Y,      "Mouse base sensitivity on the Y axis."); // Used only when anisotropy is on
@@ -67,17 +104,40 @@ PARAM  (UseSmoothing,   USE_SMOOTHING,      "Whether to smooth out functions (do
 
 PARAM_UL(LutSize,       LUT_SIZE,           "LUT data array size");
 //PARAM_F(LutStride,      LUT_STRIDE,       "Distance between y values for the LUT");
-PARAM_ARR(LutDataBuf,   LUT_DATA,           "Data of the LUT stored in a human form"); // g_LutDataBuf should not be used!
+
+// LUT points, parsed as they are written (x1;y1;x2;y2;...). A write holds a page at most, so bigger LUTs are written in
+// chunks, in order, each after setting LutDataOffset to the index of its first point. Reads start at the offset too.
+static FP_LONG g_lut_x[MAX_LUT_ARRAY_SIZE];
+static FP_LONG g_lut_y[MAX_LUT_ARRAY_SIZE];
+static unsigned int g_lut_points = 0; // End of the last chunk, 0 after a malformed one
+
+static unsigned int g_LutDataOffset = 0;
+module_param_named(LutDataOffset, g_LutDataOffset, uint, 0644);
+MODULE_PARM_DESC(LutDataOffset, "Index of the first LUT point written to or read from LutDataBuf");
+
+module_param_cb(LutDataBuf, &lut_data_ops, NULL, 0644);
+MODULE_PARM_DESC(LutDataBuf, "Data of the LUT stored in a human form");
+
+PARAM  (LutInterpolation, LUT_INTERPOLATION, "Interpolation between the LUT points (0 linear, 1 monotone cubic)");
+
+PARAM  (UseCurveTable,  USE_CURVE_TABLE,    "Evaluate the acceleration curve through a table compiled on update (0 evaluates the mode directly)");
 
 PARAM_F(RotationAngle, ROTATION_ANGLE,      "Amount of clockwise rotation (in radians)");
 PARAM_F(AngleSnap_Threshold, ANGLE_SNAPPING_THRESHOLD,      "Rotation value at which angle snapping is triggered (in radians)");
 PARAM_F(AngleSnap_Angle, ANGLE_SNAPPING_ANGLE,      "Amount of clockwise rotation for angle snapping (in radians)");
 
-FP_LONG g_LutData_x[MAX_LUT_ARRAY_SIZE]; // Array to store the x-values of the LUT data
-FP_LONG g_LutData_y[MAX_LUT_ARRAY_SIZE]; // Array to store the y-values of the LUT data
+// Compiled curve table info (read-only)
+static unsigned int g_CurveTableResolution = CURVE_TABLE_RES;
+module_param_named(CurveTableResolution, g_CurveTableResolution, uint, 0444);
+MODULE_PARM_DESC(CurveTableResolution, "Points per octave of the compiled curve table");
+
+static char g_CurveTableError[32] = "-1";
+module_param_string(CurveTableError, g_CurveTableError, sizeof(g_CurveTableError), 0444);
+MODULE_PARM_DESC(CurveTableError, "Max relative error of the compiled curve against direct evaluation (-1 when not in use)");
 
 #define FP64_ONE 4294967296ll
 #define EXP_ARG_THRESHOLD 16ll
+#define NS_TO_FP64_MS 18446744073710ll // 2^64 / NSEC_PER_MSEC, FP64_Mul(ns, NS_TO_FP64_MS) is the time in Q32.32 milliseconds
 
 // Converts given string to a unsigned long
 unsigned long atoul(const char *str) {
@@ -93,24 +153,70 @@ unsigned long atoul(const char *str) {
     return result;
 }
 
-// Updates the acceleration parameters. This is purposely done with a delay!
-// First, to not hammer too much the logic in "accelerate()", which is called VERY OFTEN!
-// Second, to fight possible cheating. However, this can be OFC changed, since we are OSS...
-#define PARAM_UPDATE(param) (FP64_FromString(g_param_##param, &g_##param))
-#define PARAM_UPDATE_UL(param) (atoul(g_param_##param))
+// Currently published parameters. Readers (the event path) only ever see a complete, validated snapshot.
+static struct accel_params __rcu *g_params;
+static DEFINE_MUTEX(g_params_lock);
+
+// Optional stages of the pipeline. A key is on while any snapshot a reader might hold needs its stage, so with the key on
+// the event path still checks the parameter itself, and with the key off the stage is patched out entirely.
+static DEFINE_STATIC_KEY_FALSE(stage_prescale);
+static DEFINE_STATIC_KEY_FALSE(stage_input_cap);
+static DEFINE_STATIC_KEY_FALSE(stage_output_cap);
+static DEFINE_STATIC_KEY_FALSE(stage_sensitivity);
+static DEFINE_STATIC_KEY_FALSE(stage_angle_snap);
+static DEFINE_STATIC_KEY_FALSE(stage_transform);
 
-// Aggregate values that don't change with speed to save on calculations done every irq
-struct ModesConstants modesConst = { .is_init = false, .C0 = 0, .r = 0, .auxiliar_accel = 0, .auxiliar_constant = 0, .accel_sub_1 = 0, .exp_sub_1 = 0, .sin_a = 0, .cos_a = 0, .as_cos = 0, .as_sin = 0, .as_half_threshold = 0 };
+static struct static_key_false *const g_stage_keys[] = {
+    &stage_prescale, &stage_input_cap, &stage_output_cap,
+    &stage_sensitivity, &stage_angle_snap, &stage_transform,
+};
 
-static ktime_t g_next_update = 0;
-INLINE void update_params(ktime_t now)
+// Stages the currently published snapshot needs (bit i stands for g_stage_keys[i])
+static unsigned int g_stages = 0;
+
+static unsigned int needed_stages(const struct accel_params *params)
 {
-    if(!g_update) return;
-    if(now < g_next_update) return;
-    g_update = 0;
-    g_next_update = now + 1000000000ll;    //Next update is allowed after 1s of delay
+    return (params->PreScale != FP64_1) << 0 |
+           (params->InputCap > 0) << 1 |
+           (params->OutputCap > 0) << 2 |
+           (params->modesConst.gain_sens != FP64_1) << 3 |
+           (params->AngleSnap_Threshold != 0) << 4 |
+           (params->modesConst.use_transform != 0) << 5;
+}
+
+static void set_stages(unsigned int stages)
+{
+    int i;
+    for (i = 0; i < ARRAY_SIZE(g_stage_keys); i++) {
+        if (stages & (1u << i))
+            static_branch_enable(g_stage_keys[i]);
+        else
+            static_branch_disable(g_stage_keys[i]);
+    }
+}
 
-    modesConst.is_init = false;
+// The curve function is called directly. It's only specialized for a snapshot once no reader can hold an older one,
+// until then the generic accel_curve_eval() (which follows whatever snapshot it's given) is used.
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 10, 0))
+DEFINE_STATIC_CALL(accel_curve, accel_curve_eval);
+#define accel_curve_call(params, speed) static_call(accel_curve)(params, speed)
+#define accel_curve_update(func) static_call_update(accel_curve, func)
+#else
+#define accel_curve_call(params, speed) accel_curve_eval(params, speed)
+#define accel_curve_update(func) do { } while (0)
+#endif
+
+// Parsing keeps the previous value when a string can't be converted
+#define PARAM_UPDATE(param) (FP64_FromString(g_param_##param, &params->param))
+#define PARAM_UPDATE_UL(param) (params->param = atoul(g_param_##param))
+
+// Parses the string parameters into 'params' and derives all the constants. Runs in process context only.
+static void parse_params(struct accel_params *params)
+{
+    params->AccelerationMode = g_AccelerationMode;
+    params->UseSmoothing = g_UseSmoothing;
+    params->UseCurveTable = g_UseCurveTable;
+    params->LutInterpolation = (unsigned char) g_LutInterpolation < LutInterp_Count ? g_LutInterpolation : LutInterp_Linear;
 
     PARAM_UPDATE(InputCap);
     PARAM_UPDATE(Sensitivity);
@@ -128,61 +234,392 @@ INLINE void update_params(ktime_t now)
     PARAM_UPDATE(AngleSnap_Angle);
     PARAM_UPDATE_UL(LutSize);
     //PARAM_UPDATE(LutStride);
-    if(g_LutSize > MAX_LUT_ARRAY_SIZE)
-        g_LutSize = MAX_LUT_ARRAY_SIZE;
-    // LutDataBuf get auto updated, we don't need to do anything, just extract the data
-    // Populate the g_LutData with the data in the buffer
-    char* p = g_param_LutDataBuf;
-    int i = 0;
-    for(; i < g_LutSize*2 && *p; i++) {
-        FP_LONG val;
-        p += FP64_FromString(p, &val) + 1; // + 1 to skip the ';'
-        // The format for the driver side is very strict tho, so don't edit it by hand pls.
-        ((i % 2 == 0) ? g_LutData_x : g_LutData_y)[i/2] = val;
-
-        // Debug stuff (you know it didn't work the first time (nor the 10th time... (that's at least 10 'blue screens')))
-        //char buf[25];
-        //FP64_ToString(val, buf, 4);
-        //printk("YeetMouse: Converted %s, next char is: %i\n", buf, *p);
-    }
-
-    // Did not work correctly
-    if(i % 2 == 1)
-        g_LutSize = 0;
+    // Only the points written so far
+    if(params->LutSize > g_lut_points)
+        params->LutSize = g_lut_points;
+    memcpy(params->LutData_x, g_lut_x, params->LutSize * sizeof(FP_LONG));
+    memcpy(params->LutData_y, g_lut_y, params->LutSize * sizeof(FP_LONG));
 
     // Sanity check
-    if((g_LutSize <= 1 /*|| g_LutStride == 0*/) && g_AccelerationMode == AccelMode_Lut)
-        g_AccelerationMode = AccelMode_Current;
+    if((params->LutSize <= 1 /*|| params->LutStride == 0*/) && params->AccelerationMode == AccelMode_Lut)
+        params->AccelerationMode = AccelMode_Current;
 
-    if (g_AccelerationMode == AccelMode_Lut &&
-        (g_LutData_x[g_LutSize-1] == g_LutData_x[g_LutSize-2] && g_LutData_y[g_LutSize-1] == g_LutData_y[g_LutSize-2]))
-        g_AccelerationMode = AccelMode_Current;
+    if (params->AccelerationMode == AccelMode_Lut &&
+        (params->LutData_x[params->LutSize-1] == params->LutData_x[params->LutSize-2] && params->LutData_y[params->LutSize-1] == params->LutData_y[params->LutSize-2]))
+        params->AccelerationMode = AccelMode_Current;
 
     // Angle snap threshold should be in range [0, PI)
-    if(g_AngleSnap_Threshold >= FP64_PI || g_AngleSnap_Threshold < 0) {
-        g_AngleSnap_Threshold = 0;
+    if(params->AngleSnap_Threshold >= FP64_PI || params->AngleSnap_Threshold < 0) {
+        params->AngleSnap_Threshold = 0;
     }
 
-    update_constants();
+    update_constants(params);
+    curve_table_build(params);
+
+    if (params->AccelerationMode != g_AccelerationMode)
+        health_inc(HEALTH_MODE_FALLBACK);
 }
 
+// Publishes a complete parameter snapshot, with g_params_lock held. The old one is freed once no event handler can see it anymore.
+static void publish_params(struct accel_params *params)
+{
+    struct accel_params *old = rcu_dereference_protected(g_params, lockdep_is_held(&g_params_lock));
+    unsigned int stages;
+
+    if (params->curve.valid)
+        FP64_ToString(params->curve.max_error, g_CurveTableError, 6);
+    else
+        strscpy(g_CurveTableError, "-1", sizeof(g_CurveTableError));
+
+    // Until the old snapshot is gone, both have to be served
+    stages = needed_stages(params);
+    set_stages(g_stages | stages);
+    accel_curve_update(accel_curve_eval);
+
+    rcu_assign_pointer(g_params, params);
+    synchronize_rcu();
+
+    g_stages = stages;
+    set_stages(stages);
+    accel_curve_update(accel_select(params));
+
+    kvfree(old);
+}
+
+// Builds a new parameter snapshot from the text parameters and publishes it
+static int commit_params(void)
+{
+    struct accel_params *params, *old;
+
+    params = kvzalloc(sizeof(*params), GFP_KERNEL);
+    if (!params)
+        return -ENOMEM;
+
+    mutex_lock(&g_params_lock);
+    old = rcu_dereference_protected(g_params, lockdep_is_held(&g_params_lock));
+    if (old)
+        memcpy(params, old, sizeof(*params));
+
+    parse_params(params);
+    publish_params(params);
+    mutex_unlock(&g_params_lock);
+
+    return 0;
+}
+
+// The Q32.32 parameters struct yeetmouse_config and struct accel_params have in common
+#define CONFIG_FP_PARAMS(X)                                                                 \
+    X(InputCap) X(Sensitivity) X(SensitivityY) X(OutputCap) X(Offset) X(PreScale)           \
+    X(Acceleration) X(Exponent) X(Midpoint) X(Motivity)                                     \
+    X(RotationAngle) X(AngleSnap_Threshold) X(AngleSnap_Angle)
+
+// Checks a binary configuration and builds a snapshot from it. Unlike the text parameters, which fall back to something
+// usable, anything invalid is refused with the reason (enum yeetmouse_config_error).
+static u32 config_to_params(const struct yeetmouse_config *cfg, struct accel_params *params)
+{
+    const bool lut_mode = cfg->AccelerationMode == AccelMode_Lut || cfg->AccelerationMode == AccelMode_CustomCurve;
+    unsigned int i;
+
+    BUILD_BUG_ON(YEETMOUSE_CONFIG_LUT_SIZE != MAX_LUT_ARRAY_SIZE);
+
+    if (cfg->magic != YEETMOUSE_CONFIG_MAGIC || cfg->size != sizeof(*cfg))
+        return YEETMOUSE_CONFIG_BAD_HEADER;
+    if (cfg->version != YEETMOUSE_CONFIG_VERSION)
+        return YEETMOUSE_CONFIG_BAD_VERSION;
+    if (cfg->AccelerationMode >= AccelMode_Count)
+        return YEETMOUSE_CONFIG_BAD_MODE;
+    if (cfg->LutSize > MAX_LUT_ARRAY_SIZE || (lut_mode && cfg->LutSize < 2))
+        return YEETMOUSE_CONFIG_BAD_LUT_SIZE;
+    for (i = 1; i < cfg->LutSize; i++) {
+        if (cfg->LutData_x[i - 1] > cfg->LutData_x[i])
+            return YEETMOUSE_CONFIG_LUT_UNSORTED;
+    }
+    if (lut_mode && cfg->LutData_x[cfg->LutSize - 1] == cfg->LutData_x[cfg->LutSize - 2])
+        return YEETMOUSE_CONFIG_LUT_FLAT_END;
+    if (cfg->AngleSnap_Threshold < 0 || cfg->AngleSnap_Threshold >= FP64_PI)
+        return YEETMOUSE_CONFIG_BAD_ANGLE_SNAP;
+    if (cfg->LutInterpolation >= LutInterp_Count)
+        return YEETMOUSE_CONFIG_BAD_INTERPOLATION;
+
+    params->AccelerationMode = cfg->AccelerationMode;
+    params->UseSmoothing = cfg->UseSmoothing;
+    params->UseCurveTable = cfg->UseCurveTable;
+    params->LutInterpolation = cfg->LutInterpolation;
+#define CONFIG_TO_PARAMS(param) params->param = cfg->param;
+    CONFIG_FP_PARAMS(CONFIG_TO_PARAMS)
+#undef CONFIG_TO_PARAMS
+    params->LutSize = cfg->LutSize;
+    memcpy(params->LutData_x, cfg->LutData_x, cfg->LutSize * sizeof(FP_LONG));
+    memcpy(params->LutData_y, cfg->LutData_y, cfg->LutSize * sizeof(FP_LONG));
+
+    // The modes fall back to AccelMode_Current on parameters they can't use
+    update_constants(params);
+    if (params->AccelerationMode != cfg->AccelerationMode)
+        return YEETMOUSE_CONFIG_BAD_PARAMETERS;
+    curve_table_build(params);
+
+    return YEETMOUSE_CONFIG_OK;
+}
+
+// Writes a committed configuration back into the text parameters, so they keep describing what's in use
+static void config_to_text(const struct yeetmouse_config *cfg)
+{
+    g_AccelerationMode = cfg->AccelerationMode;
+    g_UseSmoothing = cfg->UseSmoothing;
+    g_UseCurveTable = cfg->UseCurveTable;
+    g_LutInterpolation = cfg->LutInterpolation;
+#define CONFIG_TO_TEXT(param) FP64_ToString(cfg->param, g_param_##param, 7);
+    CONFIG_FP_PARAMS(CONFIG_TO_TEXT)
+#undef CONFIG_TO_TEXT
+    snprintf(g_param_LutSize, sizeof(g_param_LutSize), "%u", cfg->LutSize);
+
+    memcpy(g_lut_x, cfg->LutData_x, cfg->LutSize * sizeof(FP_LONG));
+    memcpy(g_lut_y, cfg->LutData_y, cfg->LutSize * sizeof(FP_LONG));
+    g_lut_points = cfg->LutSize;
+}
+
+int accel_set_config(const struct yeetmouse_config *cfg, u32 *error)
+{
+    struct accel_params *params;
+
+    params = kvzalloc(sizeof(*params), GFP_KERNEL);
+    if (!params)
+        return -ENOMEM;
+
+    *error = config_to_params(cfg, params);
+    if (*error != YEETMOUSE_CONFIG_OK) {
+        kvfree(params);
+        return -EINVAL;
+    }
+
+    // The same lock as the writes to the text parameters, so a commit through "update" can't interleave
+    kernel_param_lock(THIS_MODULE);
+    mutex_lock(&g_params_lock);
+    publish_params(params);
+    mutex_unlock(&g_params_lock);
+    config_to_text(cfg);
+    kernel_param_unlock(THIS_MODULE);
+
+    return 0;
+}
+
+int accel_get_config(struct yeetmouse_config *cfg)
+{
+    const struct accel_params *params;
+
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->magic = YEETMOUSE_CONFIG_MAGIC;
+    cfg->version = YEETMOUSE_CONFIG_VERSION;
+    cfg->size = sizeof(*cfg);
+
+    mutex_lock(&g_params_lock);
+    params = rcu_dereference_protected(g_params, lockdep_is_held(&g_params_lock));
+    if (!params) {
+        mutex_unlock(&g_params_lock);
+        return -ENODATA;
+    }
+
+    cfg->AccelerationMode = params->AccelerationMode;
+    cfg->UseSmoothing = params->UseSmoothing;
+    cfg->UseCurveTable = params->UseCurveTable;
+    cfg->LutInterpolation = params->LutInterpolation;
+#define PARAMS_TO_CONFIG(param) cfg->param = params->param;
+    CONFIG_FP_PARAMS(PARAMS_TO_CONFIG)
+#undef PARAMS_TO_CONFIG
+    cfg->LutSize = params->LutSize;
+    memcpy(cfg->LutData_x, params->LutData_x, params->LutSize * sizeof(FP_LONG));
+    memcpy(cfg->LutData_y, params->LutData_y, params->LutSize * sizeof(FP_LONG));
+    mutex_unlock(&g_params_lock);
+
+    return 0;
+}
+
+// Parses the points into g_lut_x/y starting at LutDataOffset. Writes are serialized with the commit by the kernel's param lock.
+static int lut_data_set(const char *val, const struct kernel_param *kp)
+{
+    unsigned int point = g_LutDataOffset, i = 0;
+    FP_LONG value;
+    int len;
+
+    if (point >= MAX_LUT_ARRAY_SIZE)
+        return -EINVAL;
+
+    // The format for the driver side is very strict tho, so don't edit it by hand pls.
+    while ((len = FP64_FromString(val, &value)) > 0) {
+        if (point >= MAX_LUT_ARRAY_SIZE)
+            return -E2BIG;
+
+        ((i % 2 == 0) ? g_lut_x : g_lut_y)[point] = value;
+        point += i % 2;
+        i++;
+
+        val += len;
+        if (*val == ';')
+            val++;
+    }
+
+    // Did not work correctly (an x without its y), this disables the LUT on the next update
+    g_lut_points = (i % 2 == 1) ? 0 : point;
+
+    return 0;
+}
+
+// The points from LutDataOffset on, as many as fit into a page
+static int lut_data_get(char *buffer, const struct kernel_param *kp)
+{
+    unsigned int point;
+    int len = 0;
+
+    for (point = g_LutDataOffset; point < g_lut_points && len < PAGE_SIZE - 64; point++) {
+        FP64_ToString(g_lut_x[point], buffer + len, 6);
+        len += strlen(buffer + len);
+        buffer[len++] = ';';
+        FP64_ToString(g_lut_y[point], buffer + len, 6);
+        len += strlen(buffer + len);
+        buffer[len++] = ';';
+    }
+    buffer[len++] = '\n';
+
+    return len;
+}
+
+static int update_set(const char *val, const struct kernel_param *kp)
+{
+    int ret = param_set_byte(val, kp);
+    if (ret)
+        return ret;
+
+    if (!g_update)
+        return 0;
+    g_update = 0;
+
+    return commit_params();
+}
+
+// Runs the given number of synthetic 8 kHz frames through accelerate() and returns the time it took
+static u64 benchmark_run(unsigned int frames)
+{
+    struct accel_state state;
+    ktime_t start, now = 0;
+    unsigned int i;
+
+    accel_state_init(&state);
+    state.name = "benchmark";
+    state.benchmark = true;
+
+    start = ktime_get();
+    for (i = 0; i < frames; i++) {
+        int x = (int) (i % 41) - 20, y = (int) (i % 29) - 14, wheel = 0;
+        now = ktime_add_us(now, 125);
+        accelerate(&state, now, &x, &y, &wheel);
+        cond_resched();
+    }
+
+    return ktime_to_ns(ktime_sub(ktime_get(), start));
+}
+
+// Most frames a single write can ask for, both runs together stay well within a second
+#define BENCHMARK_MAX_FRAMES 1000000
+
+// Writing N to "Benchmark" runs N frames twice. First with every stage key on and the generic curve call (the event path
+// without the static dispatch), then as currently patched. The results (ns per frame) are printed to the kernel log.
+// Parameter writes wait for it either way (sysfs runs it under the same kernel_param_lock as "update", the LUT and the
+// ioctl), so the whole run holds g_params_lock and both halves see the same snapshot. Mouse events keep going through RCU.
+static int benchmark_set(const char *val, const struct kernel_param *kp)
+{
+    const struct accel_params *params;
+    unsigned int frames;
+    u64 generic, patched;
+    int ret = kstrtouint(val, 0, &frames);
+    if (ret)
+        return ret;
+    if (frames == 0 || frames > BENCHMARK_MAX_FRAMES)
+        return -EINVAL;
+
+    mutex_lock(&g_params_lock);
+    params = rcu_dereference_protected(g_params, lockdep_is_held(&g_params_lock));
+    if (!params) {
+        mutex_unlock(&g_params_lock);
+        return -ENODATA;
+    }
+
+    set_stages((1u << ARRAY_SIZE(g_stage_keys)) - 1);
+    accel_curve_update(accel_curve_eval);
+    generic = div_u64(benchmark_run(frames) * 100, frames);
+
+    set_stages(g_stages);
+    accel_curve_update(accel_select(params));
+    patched = div_u64(benchmark_run(frames) * 100, frames);
+
+    mutex_unlock(&g_params_lock);
+
+    pr_info("YeetMouse: Benchmark (%u frames): generic %llu.%02llu ns/frame, patched %llu.%02llu ns/frame\n", frames,
+            generic / 100, generic % 100, patched / 100, patched % 100);
+
+    return 0;
+}
+
+static const struct kernel_param_ops benchmark_ops = {
+    .set = benchmark_set,
+};
+
+module_param_cb(Benchmark, &benchmark_ops, NULL, 0200);
+MODULE_PARM_DESC(Benchmark, "Runs the given number of synthetic frames (up to 1000000) through the acceleration and logs the cost per frame");
+
+int accel_init(void)
+{
+    // The LUT from "config.h", unless it was given when loading the module
+    if (g_lut_points == 0)
+        lut_data_set(s(LUT_DATA), NULL);
+
+    return commit_params();
+}
+
+void accel_exit(void)
+{
+    struct accel_params *old;
+
+    mutex_lock(&g_params_lock);
+    old = rcu_dereference_protected(g_params, lockdep_is_held(&g_params_lock));
+    RCU_INIT_POINTER(g_params, NULL);
+    mutex_unlock(&g_params_lock);
+
+    synchronize_rcu();
+    kvfree(old);
+}
+
+void accel_state_init(struct accel_state *state)
+{
+    state->last = 0;
+    state->last_ms = One;
+    state->carry_x = 0;
+    state->carry_y = 0;
+    state->name = NULL;
+    state->speed = 0;
+    state->gain = FP64_1;
+    state->benchmark = false;
+}
+
+// The frames of the Benchmark parameter are left out of the health counters and the tracepoint
+#define frame_health_inc(state, which) do { if (likely(!(state)->benchmark)) health_inc(which); } while (0)
+
 // Acceleration happens here
-int accelerate(int *x, int *y, int *wheel)
+int accelerate(struct accel_state *state, ktime_t now, int *x, int *y, int *wheel)
 {
-    FP_LONG delta_x, delta_y, ms, speed;
+    FP_LONG delta_x, delta_y, ms, speed, magnitude, curve_in, curve_out;
+    const int in_x = *x, in_y = *y;
     //static long buffer_x = 0;
     //static long buffer_y = 0;
-    //Static float assignment should happen at compile-time and thus should be safe here. However, avoid non-static assignment of floats outside kernel_fpu_begin()/kernel_fpu_end()
-    static FP_LONG carry_x = 0;
-    static FP_LONG carry_y = 0;
-    //static FP_LONG carry_whl = 0;
-    static FP_LONG last_ms = One;
-    static ktime_t last;
-    ktime_t now;
+    const struct accel_params *params;
+    bool snapped = false;
     int status = 0;
 
-    if(!modesConst.is_init)
-        update_constants();
+    rcu_read_lock();
+    params = rcu_dereference(g_params);
+    if (unlikely(!params)) {
+        rcu_read_unlock();
+        return -ENODATA;
+    }
 
     delta_x = FP64_FromInt(*x);
     delta_y = FP64_FromInt(*y);
@@ -192,9 +629,8 @@ int accelerate(int *x, int *y, int *wheel)
     //delta_x = FP64_Add(delta_x, FP64_FromInt((int) buffer_x)); buffer_x = 0;
     //delta_y = FP64_Add(delta_y, FP64_FromInt((int) buffer_y)); buffer_y = 0;
 
-    //Calculate frametime
-    now = ktime_get(); // ns
-    long long dt = (now - last);
+    //Calculate frametime (the timestamp comes from the device or the input core, see driver.c)
+    long long dt = (now - state->last);
     //int frac = dt % 10000;
     // We can't just store milliseconds as this would lose a lot of precision (nano -> mili, that's 10^-6 difference).
     // But we have only Q16.16 bits of precision, meaning 16 bits for the fractional part of the number (it's constant!).
@@ -204,155 +640,121 @@ int accelerate(int *x, int *y, int *wheel)
     // that would be lost either way.
     /// THE ABOVE NO LONGER HOLDS, AS I'VE MOVED (AGAIN), THIS TIME TO 64bit FIXED POINT MATH
     //ms = FP64_FromInt(dt / 10000ll) + FP64_Div(FP64_FromInt(frac), fp64_10000); // NOT MILLISECONDS, its ms * 100
-    ms = FP64_DivPrecise(FP64_FromInt(dt), FP64_FromInt(1000000));
-    last = now;
-    //if(ms < 1) ms = last_ms;    //Sometimes, urbs appear bunched -> Beyond µs resolution so the timing reading is plain wrong. Fallback to last known valid frametime
+    // Nanoseconds straight to Q32.32 milliseconds with a multiply, anything above the 100ms cap is cut short before it can overflow
+    ms = dt < 100 * NSEC_PER_MSEC ? FP64_Mul(dt, NS_TO_FP64_MS) : FP64_100;
+    state->last = now;
+    // Only possible when a device switches between its own and the host's clock
+    if(dt <= 0) ms = state->last_ms;
+    if(dt <= 0 || dt >= 100 * NSEC_PER_MSEC) frame_health_inc(state, HEALTH_DT_CLAMP);
+    //if(ms < 1) ms = state->last_ms;    //Sometimes, urbs appear bunched -> Beyond µs resolution so the timing reading is plain wrong. Fallback to last known valid frametime
     // Editor node: I have no idea, what this line above really does, but commenting it out solves all my problems
     // with incorrect data. It seems that it tries to fix a problem that doesn't exist, or doesn't exist on my
     // specific setup (PC / System / Mice)
     if(ms > FP64_100) ms = FP64_100;
 
     //if(ms > 100) ms = 100;      //Original InterAccel has 200 here. RawAccel rounds to 100. So do we.
-    last_ms = ms;
-
-    //Update acceleration parameters periodically
-    update_params(now);
+    state->last_ms = ms;
 
     //Calculate velocity (one step before rate, which divides rate by the last frametime)
-    speed = FP64_Sqrt(FP64_Add(FP64_Mul(delta_x, delta_x), FP64_Mul(delta_y, delta_y)));
+    magnitude = FP64_Sqrt(FP64_Add(FP64_Mul(delta_x, delta_x), FP64_Mul(delta_y, delta_y)));
+    speed = magnitude;
 
     // Apply Pre-Scale
-    if(g_PreScale != FP64_1)
-        speed = FP64_Mul(speed, g_PreScale);
+    if(static_branch_unlikely(&stage_prescale) && params->PreScale != FP64_1)
+        speed = FP64_Mul(speed, params->PreScale);
 
     //Apply speedcap
-    if(g_InputCap > 0){
-        //if(speed >= g_InputCap) {
-        if(FP64_Sub(speed, g_InputCap) > 0) {
-            speed = g_InputCap;
+    if(static_branch_unlikely(&stage_input_cap) && params->InputCap > 0){
+        //if(speed >= params->InputCap) {
+        if(FP64_Sub(speed, params->InputCap) > 0) {
+            speed = params->InputCap;
+            frame_health_inc(state, HEALTH_INPUT_CAP);
         }
     }
 
     //Calculate rate from traveled overall distance and add possible rate offsets
+    // Exact, everything after it depends on the speed and FP64_DivNewton() keeps only about 24 bits without being faster (see Performance.md)
     speed = FP64_DivPrecise(speed, ms);
-    speed = FP64_Sub(speed, g_Offset);
+    speed = FP64_Sub(speed, params->Offset);
+
+    curve_in = speed;
 
     // Apply acceleration if movement is over offset
     if (speed > 0) {
-        switch (g_AccelerationMode) {
-            case AccelMode_Linear:
-                speed = accel_linear(speed);
-                break;
-            case AccelMode_Power:
-                speed = accel_power(speed);
-                break;
-            case AccelMode_Classic:
-                speed = accel_classic(speed);
-                break;
-            case AccelMode_Motivity:
-                speed = accel_motivity(speed);
-                break;
-            case AccelMode_Synchronous:
-                speed = accel_synchronous(speed);
-                break;
-            case AccelMode_Natural:
-                speed = accel_natural(speed);
-                break;
-            case AccelMode_Jump:
-                speed = accel_jump(speed);
-                break;
-            case AccelMode_Lut: case AccelMode_CustomCurve:
-                speed = accel_lut(speed);
-                break;
-            default:
-                speed = FP64_1;
-                break;
-        }
-    } else {
+        // The LUT holds the first point's value below it, and extrapolates past the last one
+        if ((params->AccelerationMode == AccelMode_Lut || params->AccelerationMode == AccelMode_CustomCurve) &&
+            params->LutSize > 0 && (speed < params->LutData_x[0] || speed > params->LutData_x[params->LutSize - 1]))
+            frame_health_inc(state, HEALTH_LUT_RANGE);
+        speed = accel_curve_call(params, speed);
+    }
+    else
         speed = FP64_1;
+    curve_out = speed;
+
+    // Apply Output Limit, to the gain itself (before the sensitivity, the way the GUI shows it)
+    if(static_branch_unlikely(&stage_output_cap) && params->OutputCap > 0 && speed > params->OutputCap) {
+        speed = params->OutputCap;
+        frame_health_inc(state, HEALTH_OUTPUT_CAP);
     }
 
-    // Actually apply accelerated sensitivity, allow post-scaling and apply carry from previous round
-    // Like RawAccel, sensitivity will be a final multiplier:
-    if (g_Sensitivity == g_SensitivityY) {
-        if(g_Sensitivity != FP64_1)
-            speed = FP64_Mul(speed, g_Sensitivity);
-
-        // Apply Output Limit
-        if(g_OutputCap > 0)
-            speed = FP64_Min(g_OutputCap, speed);
-
-        // Apply acceleration
-        delta_x = FP64_Mul(delta_x, speed);
-        delta_y = FP64_Mul(delta_y, speed);
-    } else {
-        speed = FP64_Mul(speed, g_Sensitivity);
-        FP_LONG speed_Y = FP64_Mul(speed, g_SensitivityY);
-
-        // Apply Output Limit
-        if(g_OutputCap > 0) {
-            speed = FP64_Min(g_OutputCap, speed);
-            speed_Y = FP64_Min(g_OutputCap, speed_Y);
+    // Like RawAccel, sensitivity will be a final multiplier. Unless it's a part of the transform, it goes straight into the gain
+    if(static_branch_unlikely(&stage_sensitivity) && params->modesConst.gain_sens != FP64_1)
+        speed = FP64_Mul(speed, params->modesConst.gain_sens);
+
+    // Apply acceleration
+    delta_x = FP64_Mul(delta_x, speed);
+    delta_y = FP64_Mul(delta_y, speed);
+
+    // Angle Snapping (the snapped motion comes out already transformed)
+    if(static_branch_unlikely(&stage_angle_snap) && params->AngleSnap_Threshold != 0) {
+        // Without the transform the direction didn't change, so the length is known without another square root
+        if (params->modesConst.use_transform) {
+            FP_LONG scaled_x = FP64_Mul(delta_x, params->Sensitivity);
+            FP_LONG scaled_y = FP64_Mul(delta_y, params->SensitivityY);
+            magnitude = FP64_Sqrt(FP64_Add(FP64_Mul(scaled_x, scaled_x), FP64_Mul(scaled_y, scaled_y)));
         }
+        else
+            magnitude = FP64_Mul(magnitude, speed);
 
-        // Apply acceleration
-        delta_x = FP64_Mul(delta_x, speed);
-        delta_y = FP64_Mul(delta_y, speed_Y);
+        snapped = angle_snap(params, &delta_x, &delta_y, magnitude);
     }
 
-    // Angle Snapping
-    if(modesConst.as_half_threshold != 0) {
-        FP_LONG delta_mag = FP64_Sqrt(FP64_Add(FP64_Mul(delta_x, delta_x), FP64_Mul(delta_y, delta_y)));
-        if (delta_mag != 0) {
-            FP_LONG current_angle = FP64_Atan2(delta_y, delta_x);
-            FP_LONG angle_diff = FP64_Sub(g_AngleSnap_Angle, current_angle);
-            FP_LONG angle_diff_quarter = FP64_PI_2 - FP64_Abs(angle_diff);
-
-            int sign = FP64_Sign(angle_diff_quarter);
-            angle_diff_quarter = FP64_Abs(angle_diff_quarter) - FP64_PI_2;
-
-            if (FP64_Abs(angle_diff_quarter) <= modesConst.as_half_threshold) {
-                delta_x = FP64_Mul(modesConst.as_cos, delta_mag) * sign;
-                delta_y = FP64_Mul(modesConst.as_sin, delta_mag) * sign;
-            }
-        }
-    }
+    // Apply sensitivity, anisotropy and rotation as one matrix
+    if(static_branch_unlikely(&stage_transform) && params->modesConst.use_transform && !snapped)
+        accel_transform(params, &delta_x, &delta_y);
 
-    delta_x = FP64_Add(delta_x, carry_x);
-    delta_y = FP64_Add(delta_y, carry_y);
+    delta_x = FP64_Add(delta_x, state->carry_x);
+    delta_y = FP64_Add(delta_y, state->carry_y);
 
     // I don't do wheel, sorry
-    //delta_whl *= g_ScrollsPerTick/3.0f;
-
-    // Apply Rotation after everything else to keep the precision
-    if(g_RotationAngle != 0) {
-        FP_LONG new_delta_x = FP64_Mul(delta_x, modesConst.cos_a) - FP64_Mul(delta_y, modesConst.sin_a);
-        delta_y = FP64_Mul(delta_x, modesConst.sin_a) + FP64_Mul(delta_y, modesConst.cos_a);
-        delta_x = new_delta_x;
-    }
+    //delta_whl *= params->ScrollsPerTick/3.0f;
 
     //Cast back to int
     *x = FP64_RoundToInt(delta_x);
     *y = FP64_RoundToInt(delta_y);
 
+    rcu_read_unlock();
+
     //Save carry for next round
-    carry_x = FP64_Sub(delta_x, FP64_FromInt(*x));
-    carry_y = FP64_Sub(delta_y, FP64_FromInt(*y));
+    state->carry_x = FP64_Sub(delta_x, FP64_FromInt(*x));
+    state->carry_y = FP64_Sub(delta_y, FP64_FromInt(*y));
+    // Rounding leaves less than half a count, anything else means the motion didn't fit into an int
+    if (unlikely(state->carry_x < -Half || state->carry_x >= Half || state->carry_y < -Half || state->carry_y >= Half)) {
+        state->carry_x = state->carry_y = 0;
+        frame_health_inc(state, HEALTH_CARRY_OVERFLOW);
+    }
+    frame_health_inc(state, HEALTH_FRAMES);
     //carry_whl = delta_whl - *wheel;
 
-    // Used to very roughly estimate the performance, and 0.1% lows
-    // ktime_t iter_time = ktime_sub(ktime_get(), now);
-    // static ktime_t elapsed_time, highest_elapsed_time;
-    // static int iter = 0;
-    // elapsed_time += iter_time;
-    // if(iter_time > highest_elapsed_time)
-    //     highest_elapsed_time = iter_time;
-    // if(++iter == 1000) {
-    //     iter = 0;
-    //     pr_info("YeetMouse: Sum of 1000 iters: %lldns, low 0.1%%: %lldns\n", ktime_to_ns(elapsed_time), highest_elapsed_time);
-    //     elapsed_time = 0;
-    //     highest_elapsed_time = 0;
-    // }
+    // A static branch, free unless the event is enabled. The cost of this function is measured by the caller, see stats.h
+    if (likely(!state->benchmark))
+        trace_yeetmouse_frame(state->name ?: "", in_x, in_y, dt, curve_in, curve_out, *x, *y, state->carry_x, state->carry_y);
+
+    // Picked up by the caller for the motion ring
+    if (motion_ring_enabled()) {
+        state->speed = curve_in;
+        state->gain = curve_out;
+    }
 
     return status;
 }
@@ -1,6 +1,36 @@
 #ifndef _ACCEL_H
 #define _ACCEL_H
 
-int accelerate(int *x, int *y, int *wheel);
+#include <linux/types.h>
+#include <linux/ktime.h>
+#include <linux/cache.h>
+#include "FixedMath/Fixed64.h"
+
+struct yeetmouse_config;
+
+// Motion state of a single device. Every input handle owns one, so devices never share a frame clock or a carry,
+// and the hot fields of two devices never end up on the same cache line.
+struct accel_state {
+    ktime_t last;       // Timestamp of the previous frame
+    FP_LONG last_ms;    // Frame time of the previous frame (in ms)
+    FP_LONG carry_x;    // Sub-pixel remainders carried over to the next frame
+    FP_LONG carry_y;
+    //FP_LONG carry_whl;
+    const char *name;   // Device name for the tracepoints
+    FP_LONG speed;      // Curve input and output of the last frame, only kept while the motion ring is open
+    FP_LONG gain;
+    bool benchmark;     // Synthetic frames of the Benchmark parameter, not counted or traced
+} ____cacheline_aligned;
+
+int accel_init(void);
+void accel_exit(void);
+
+void accel_state_init(struct accel_state *state);
+// 'now' is the timestamp of the frame, the frame time is measured against the previous one
+int accelerate(struct accel_state *state, ktime_t now, int *x, int *y, int *wheel);
+
+// Binary configuration (see shared_definitions.h). A rejected one returns -EINVAL with the reason in 'error'.
+int accel_set_config(const struct yeetmouse_config *cfg, u32 *error);
+int accel_get_config(struct yeetmouse_config *cfg);
 
 #endif /* _ACCEL_H */
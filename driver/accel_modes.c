@@ -6,51 +6,59 @@
 
 #define EXP_ARG_THRESHOLD 16ll
 
+static void synchronous_build_lut(struct accel_params *params);
+static void lut_build_tangents(struct accel_params *params);
+static void lut_build_grid(struct accel_params *params);
+
 // Recalculate new modes constants
-void update_constants(void) {
+void update_constants(struct accel_params *params) {
     // General
-    modesConst.accel_sub_1 = FP64_Sub(g_Acceleration, FP64_1);
-    modesConst.exp_sub_1 = FP64_Sub(g_Exponent, FP64_1);
-    modesConst.cap_x = 0;
-    modesConst.cap_y = 0;
-    modesConst.gain_constant = 0;
-    modesConst.sign = FP64_1;
+    params->modesConst.accel_sub_1 = FP64_Sub(params->Acceleration, FP64_1);
+    params->modesConst.exp_sub_1 = FP64_Sub(params->Exponent, FP64_1);
+    params->modesConst.cap_x = 0;
+    params->modesConst.cap_y = 0;
+    params->modesConst.gain_constant = 0;
+    params->modesConst.sign = FP64_1;
 
     // Synchronous
-    if (g_AccelerationMode == AccelMode_Synchronous) {
-        if (g_Motivity <= FP64_1) {
+    if (params->AccelerationMode == AccelMode_Synchronous) {
+        if (params->Motivity <= FP64_1) {
             printk("YeetMouse: Error: Acceleration mode 'Synchronous' is not supported for motivity 1.\n");
-            g_Acceleration = 0;
-            g_AccelerationMode = AccelMode_Current;
+            params->Acceleration = 0;
+            params->AccelerationMode = AccelMode_Current;
         }
         else {
-            modesConst.logMot = FP64_Log(g_Motivity);
-            modesConst.gammaConst = FP64_DivPrecise(g_Exponent, modesConst.logMot);
-            modesConst.logSync = FP64_Log(g_Acceleration);
+            params->modesConst.logMot = FP64_Log(params->Motivity);
+            params->modesConst.gammaConst = FP64_DivPrecise(params->Exponent, params->modesConst.logMot);
+            params->modesConst.logSync = FP64_Log(params->Acceleration);
 
             // sharpness = (midpoint == 0) ? 16.0 : (0.5 / midpoint)
-            modesConst.sharpness = (g_Midpoint == 0)
+            params->modesConst.sharpness = (params->Midpoint == 0)
                 ? FP64_FromInt(16)
-                : FP64_DivPrecise(FP64_0_5, g_Midpoint);
+                : FP64_DivPrecise(FP64_0_5, params->Midpoint);
+
+            params->modesConst.sharpnessRecip = FP64_DivPrecise(FP64_1, params->modesConst.sharpness);
+            params->modesConst.useClamp = (params->modesConst.sharpness >= FP64_FromInt(16));
 
-            modesConst.sharpnessRecip = FP64_DivPrecise(FP64_1, modesConst.sharpness);
-            modesConst.useClamp = (modesConst.sharpness >= FP64_FromInt(16));
+            params->modesConst.minSens = FP64_DivPrecise(FP64_1, params->Motivity);
+            params->modesConst.maxSens = params->Motivity;
 
-            modesConst.minSens = FP64_DivPrecise(FP64_1, g_Motivity);
-            modesConst.maxSens = g_Motivity;
+            // Smoothing integrates the legacy curve, so the table has to follow every parameter change
+            if (params->UseSmoothing)
+                synchronous_build_lut(params);
         }
     }
 
     // Linear
-    if (g_AccelerationMode == AccelMode_Linear) {
-        if (g_Acceleration == 0) {
+    if (params->AccelerationMode == AccelMode_Linear) {
+        if (params->Acceleration == 0) {
             printk("YeetMouse: Error: Acceleration mode 'Linear' is not supported for acceleration 0.\n");
-            g_Acceleration = 0;
-            g_AccelerationMode = AccelMode_Current;
+            params->Acceleration = 0;
+            params->AccelerationMode = AccelMode_Current;
         }
-        else if (g_UseSmoothing) {
+        else if (params->UseSmoothing) {
             FP_LONG sign = FP64_1;
-            FP_LONG cap_y = FP64_Sub(g_Midpoint, FP64_1);
+            FP_LONG cap_y = FP64_Sub(params->Midpoint, FP64_1);
             FP_LONG cap_x = FP64_FromInt(0);
             FP_LONG constant = FP64_FromInt(0);
             if (cap_y != 0) {
@@ -58,26 +66,26 @@ void update_constants(void) {
                     cap_y = FP64_Mul(cap_y, Neg1);
                     sign = Neg1;
                 }
-                cap_x = FP64_DivPrecise(FP64_DivPrecise(cap_y, FP64_FromInt(2)), g_Acceleration);
+                cap_x = FP64_DivPrecise(FP64_DivPrecise(cap_y, FP64_FromInt(2)), params->Acceleration);
             }
             constant = FP64_DivPrecise(FP64_Mul(FP64_Mul(cap_y, Neg1), cap_x), FP64_FromInt(2));
-            modesConst.cap_x = cap_x;
-            modesConst.cap_y = cap_y;
-            modesConst.gain_constant = constant;
-            modesConst.sign = sign;
+            params->modesConst.cap_x = cap_x;
+            params->modesConst.cap_y = cap_y;
+            params->modesConst.gain_constant = constant;
+            params->modesConst.sign = sign;
         }
     }
 
     // Classic
-    if (g_AccelerationMode == AccelMode_Classic) {
-        if (g_UseSmoothing && (g_Exponent == 0 || modesConst.exp_sub_1 == 0)) {
+    if (params->AccelerationMode == AccelMode_Classic) {
+        if (params->UseSmoothing && (params->Exponent == 0 || params->modesConst.exp_sub_1 == 0)) {
             printk("YeetMouse: Error: Acceleration mode 'Classic' is not supported for exponent 0 or 1 while using the the smooth cap.\n");
-            g_Acceleration = 0;
-            g_AccelerationMode = AccelMode_Current;
+            params->Acceleration = 0;
+            params->AccelerationMode = AccelMode_Current;
         } else {
-            if (g_UseSmoothing) {
+            if (params->UseSmoothing) {
                 FP_LONG sign = FP64_1;
-                FP_LONG cap_y = FP64_Sub(g_Midpoint, FP64_1);
+                FP_LONG cap_y = FP64_Sub(params->Midpoint, FP64_1);
                 FP_LONG cap_x = FP64_FromInt(0);
                 FP_LONG constant = FP64_FromInt(0);
                 if (cap_y != 0) {
@@ -85,158 +93,174 @@ void update_constants(void) {
                         cap_y = FP64_Mul(cap_y, Neg1);
                         sign = Neg1;
                     }
-                    cap_x = FP64_DivPrecise(FP64_Pow(FP64_DivPrecise(cap_y, g_Exponent),
-                                                     FP64_DivPrecise(FP64_1, modesConst.exp_sub_1)), g_Acceleration);
+                    cap_x = FP64_DivPrecise(FP64_Pow(FP64_DivPrecise(cap_y, params->Exponent),
+                                                     FP64_DivPrecise(FP64_1, params->modesConst.exp_sub_1)), params->Acceleration);
                 }
-                FP_LONG factor = FP64_DivPrecise(FP64_Sub(g_Exponent, FP64_1), g_Exponent);
+                FP_LONG factor = FP64_DivPrecise(FP64_Sub(params->Exponent, FP64_1), params->Exponent);
                 constant = FP64_Mul(cap_y, cap_x);
                 constant = FP64_Mul(factor, constant);
                 constant = FP64_Mul(constant, Neg1);
-                modesConst.cap_x = cap_x;
-                modesConst.cap_y = cap_y;
-                modesConst.gain_constant = constant;
-                modesConst.sign = sign;
+                params->modesConst.cap_x = cap_x;
+                params->modesConst.cap_y = cap_y;
+                params->modesConst.gain_constant = constant;
+                params->modesConst.sign = sign;
             }
         }
     }
 
     // Natural
-    if (g_AccelerationMode == AccelMode_Natural) {
-        if (modesConst.exp_sub_1 == 0 || g_Exponent == FP64_1) {
+    if (params->AccelerationMode == AccelMode_Natural) {
+        if (params->modesConst.exp_sub_1 == 0 || params->Exponent == FP64_1) {
             printk("YeetMouse: Error: Acceleration mode 'Natural' is not supported for exponent 1.\n");
-            g_Acceleration = 0;
-            g_AccelerationMode = AccelMode_Current;
+            params->Acceleration = 0;
+            params->AccelerationMode = AccelMode_Current;
         }
-        if (g_Acceleration == 0) {
+        if (params->Acceleration == 0) {
             printk("YeetMouse: Error: Acceleration mode 'Natural' is not supported for acceleration 0.\n");
-            g_Acceleration = 0;
-            g_AccelerationMode = AccelMode_Current;
+            params->Acceleration = 0;
+            params->AccelerationMode = AccelMode_Current;
         }
         else {
-            modesConst.auxiliar_accel = FP64_DivPrecise(g_Acceleration, FP64_Abs(modesConst.exp_sub_1));
-            modesConst.auxiliar_constant = FP64_DivPrecise(-modesConst.exp_sub_1, modesConst.auxiliar_accel);
+            params->modesConst.auxiliar_accel = FP64_DivPrecise(params->Acceleration, FP64_Abs(params->modesConst.exp_sub_1));
+            params->modesConst.auxiliar_accel_rcp = FP64_DivPrecise(FP64_1, params->modesConst.auxiliar_accel);
+            params->modesConst.auxiliar_constant = FP64_DivPrecise(-params->modesConst.exp_sub_1, params->modesConst.auxiliar_accel);
         }
     }
 
     // Jump
-    if (g_AccelerationMode == AccelMode_Jump) {
-        if (g_Exponent == 0 || g_Midpoint == 0) {
+    if (params->AccelerationMode == AccelMode_Jump) {
+        if (params->Exponent == 0 || params->Midpoint == 0) {
             printk("YeetMouse: Error: Acceleration mode 'Jump' is not supported for exponent 0 or midpoint 0.\n");
-            g_Exponent = 1;
-            g_Midpoint = 1;
-            g_Acceleration = 0;
-            g_AccelerationMode = AccelMode_Current;
+            params->Exponent = 1;
+            params->Midpoint = 1;
+            params->Acceleration = 0;
+            params->AccelerationMode = AccelMode_Current;
         }
         else {
-            modesConst.r = FP64_DivPrecise(FP64_Mul(Two, Pi), FP64_Mul(g_Exponent, g_Midpoint));
-            FP_LONG r_times_m = FP64_Mul(modesConst.r, g_Midpoint);
+            params->modesConst.r = FP64_DivPrecise(FP64_Mul(Two, Pi), FP64_Mul(params->Exponent, params->Midpoint));
+            params->modesConst.r_rcp = FP64_DivPrecise(FP64_1, params->modesConst.r);
+            FP_LONG r_times_m = FP64_Mul(params->modesConst.r, params->Midpoint);
 
             // Safely exponentiate without overflow (ln(1+exp(x)) when x -> 'inf' = ln(exp(x)) = x. (in practice works for x >= 8))
             if (r_times_m < (EXP_ARG_THRESHOLD << FP64_Shift))
-                modesConst.C0 = FP64_Mul(FP64_DivPrecise(FP64_Log(FP64_Add(1, FP64_Exp(r_times_m))), modesConst.r), modesConst.accel_sub_1);
+                params->modesConst.C0 = FP64_Mul(FP64_DivPrecise(FP64_Log(FP64_Add(1, FP64_Exp(r_times_m))), params->modesConst.r), params->modesConst.accel_sub_1);
             else
-                modesConst.C0 = FP64_Mul(modesConst.accel_sub_1, g_Midpoint);
+                params->modesConst.C0 = FP64_Mul(params->modesConst.accel_sub_1, params->Midpoint);
         }
     }
 
     // Power
-    if (g_AccelerationMode == AccelMode_Power) {
-        if (g_Exponent == 0 || g_Exponent == -FP64_1 || g_Acceleration == 0) {
+    if (params->AccelerationMode == AccelMode_Power) {
+        if (params->Exponent == 0 || params->Exponent == -FP64_1 || params->Acceleration == 0) {
             printk("YeetMouse: Error: Acceleration mode 'Power' is not supported for exponent 0 or -1 or acceleration 0.\n");
-            g_Acceleration = 0;
-            g_AccelerationMode = AccelMode_Current;
+            params->Acceleration = 0;
+            params->AccelerationMode = AccelMode_Current;
         }
-        else if (g_Midpoint == 0) {
-            modesConst.offset_x = 0;
-            modesConst.power_constant = 0;
+        else if (params->Midpoint == 0) {
+            params->modesConst.offset_x = 0;
+            params->modesConst.power_constant = 0;
         }
-        else if (FP64_DivPrecise(g_Midpoint, FP64_Mul(g_Acceleration, g_Exponent)) > FP64_100) { // 100 here is completely arbitrary
+        else if (FP64_DivPrecise(params->Midpoint, FP64_Mul(params->Acceleration, params->Exponent)) > FP64_100) { // 100 here is completely arbitrary
             printk("YeetMouse: Error: Invalid parameters for the 'Power' mode.\n");
-            g_Acceleration = 0;
-            g_AccelerationMode = AccelMode_Current;
+            params->Acceleration = 0;
+            params->AccelerationMode = AccelMode_Current;
         }
         else {
-            // modesConst.offset_x = FP64_DivPrecise(FP64_Pow(FP64_DivPrecise(g_Midpoint, FP64_Add(g_Exponent, FP64_ONE)),
-            //     FP64_DivPrecise(FP64_ONE, g_Exponent)), g_Acceleration);
-            // modesConst.power_constant = FP64_DivPrecise(FP64_Mul(modesConst.offset_x, FP64_Mul(g_Midpoint, g_Exponent)), FP64_Add(g_Exponent, FP64_ONE));
+            // params->modesConst.offset_x = FP64_DivPrecise(FP64_Pow(FP64_DivPrecise(params->Midpoint, FP64_Add(params->Exponent, FP64_ONE)),
+            //     FP64_DivPrecise(FP64_ONE, params->Exponent)), params->Acceleration);
+            // params->modesConst.power_constant = FP64_DivPrecise(FP64_Mul(params->modesConst.offset_x, FP64_Mul(params->Midpoint, params->Exponent)), FP64_Add(params->Exponent, FP64_ONE));
 
-            FP_LONG exponent_plus_one = FP64_Add(g_Exponent, FP64_1);
-            FP_LONG one_over_exponent = FP64_DivPrecise(FP64_1, g_Exponent);
-            FP_LONG base_value = FP64_DivPrecise(g_Midpoint, exponent_plus_one);
+            FP_LONG exponent_plus_one = FP64_Add(params->Exponent, FP64_1);
+            FP_LONG one_over_exponent = FP64_DivPrecise(FP64_1, params->Exponent);
+            FP_LONG base_value = FP64_DivPrecise(params->Midpoint, exponent_plus_one);
 
             FP_LONG pow_result = FP64_Pow(base_value, one_over_exponent);
-            modesConst.offset_x = FP64_DivPrecise(pow_result, g_Acceleration);
+            params->modesConst.offset_x = FP64_DivPrecise(pow_result, params->Acceleration);
 
-            FP_LONG intermediate = FP64_Mul(modesConst.offset_x, FP64_Mul(g_Midpoint, g_Exponent));
-            modesConst.power_constant = FP64_DivPrecise(intermediate, exponent_plus_one);
+            FP_LONG intermediate = FP64_Mul(params->modesConst.offset_x, FP64_Mul(params->Midpoint, params->Exponent));
+            params->modesConst.power_constant = FP64_DivPrecise(intermediate, exponent_plus_one);
         }
     }
 
     // Lut (Validation)
-    if (g_AccelerationMode == AccelMode_Lut) {
-        if (g_LutSize <= 1|| g_LutData_x[g_LutSize-1] == g_LutData_x[g_LutSize-2])
-            g_AccelerationMode = AccelMode_Current;
+    if (params->AccelerationMode == AccelMode_Lut) {
+        if (params->LutSize <= 1|| params->LutData_x[params->LutSize-1] == params->LutData_x[params->LutSize-2])
+            params->AccelerationMode = AccelMode_Current;
     }
 
     // Check if LUT_x is sorted
-    for (int i = 1; i < g_LutSize; i++) {
-        if (g_LutData_x[i - 1] > g_LutData_x[i]) {
-            g_AccelerationMode = AccelMode_Current;
+    for (int i = 1; i < params->LutSize; i++) {
+        if (params->LutData_x[i - 1] > params->LutData_x[i]) {
+            params->AccelerationMode = AccelMode_Current;
             printk("YeetMouse: Error: Acceleration mode 'LUT' is not supported for unsorted LUT_x.\n");
             break;
         }
     }
 
-    // Rotation (precalculate the trig. functions)
-    modesConst.sin_a = FP64_Sin(g_RotationAngle);
-    modesConst.cos_a = FP64_Cos(g_RotationAngle);
-
-    modesConst.as_cos = FP64_Cos(g_AngleSnap_Angle);
-    modesConst.as_sin = FP64_Sin(g_AngleSnap_Angle);
-    modesConst.as_half_threshold = FP64_DivPrecise(g_AngleSnap_Threshold, 2ll << FP64_Shift);
+    // Lut (uniform grid)
+    if ((params->AccelerationMode == AccelMode_Lut || params->AccelerationMode == AccelMode_CustomCurve) && params->LutSize >= 2) {
+        if (params->LutInterpolation == LutInterp_MonotoneCubic)
+            lut_build_tangents(params);
+        lut_build_grid(params);
+    }
 
-    modesConst.is_init = 1;
+    // Output transform (precalculate the trig. functions)
+    FP_LONG sin_a = FP64_Sin(params->RotationAngle);
+    FP_LONG cos_a = FP64_Cos(params->RotationAngle);
+
+    params->modesConst.use_transform = params->RotationAngle != 0 || params->Sensitivity != params->SensitivityY;
+    params->modesConst.gain_sens = params->modesConst.use_transform ? FP64_1 : params->Sensitivity;
+    params->modesConst.m_xx = FP64_Mul(cos_a, params->Sensitivity);
+    params->modesConst.m_xy = -FP64_Mul(sin_a, params->SensitivityY);
+    params->modesConst.m_yx = FP64_Mul(sin_a, params->Sensitivity);
+    params->modesConst.m_yy = FP64_Mul(cos_a, params->SensitivityY);
+
+    // Angle snapping happens between the sensitivity and the rotation, so with the transform the motion is tested
+    // against the direction pulled back through the sensitivity, and snaps to the rotated one
+    FP_LONG as_cos = FP64_Cos(params->AngleSnap_Angle);
+    FP_LONG as_sin = FP64_Sin(params->AngleSnap_Angle);
+
+    if (params->modesConst.use_transform) {
+        params->modesConst.as_dot_x = FP64_Mul(as_cos, params->Sensitivity);
+        params->modesConst.as_dot_y = FP64_Mul(as_sin, params->SensitivityY);
+        params->modesConst.as_out_x = FP64_Sub(FP64_Mul(cos_a, as_cos), FP64_Mul(sin_a, as_sin));
+        params->modesConst.as_out_y = FP64_Add(FP64_Mul(sin_a, as_cos), FP64_Mul(cos_a, as_sin));
+    }
+    else {
+        params->modesConst.as_dot_x = params->modesConst.as_out_x = as_cos;
+        params->modesConst.as_dot_y = params->modesConst.as_out_y = as_sin;
+    }
+    params->modesConst.as_cos_half_threshold = FP64_Cos(FP64_DivPrecise(params->AngleSnap_Threshold, 2ll << FP64_Shift));
 }
 
-#define SYNC_START (-3)
-#define SYNC_STOP (9)
-#define SYNC_NUM (8)
-#define SYNC_CAPACITY ((SYNC_STOP - SYNC_START) * SYNC_NUM + 1)
-
-// Local LUT storage for synchronous smoothing
-static struct {
-    FP_LONG x_start;                 // 2^SYNC_START
-    FP_LONG data[SYNC_CAPACITY];     // monotonic over x
-} s_sync_lut;
-
-static bool s_sync_lut_ready = false;
-
-static FP_LONG synchronous_legacy(FP_LONG x) {
-    if (modesConst.useClamp) {
-        FP_LONG L = FP64_Mul(modesConst.gammaConst, FP64_Sub(FP64_Log(x), modesConst.logSync));
-        if (L < FP64_1) return modesConst.minSens;
-        if (L > -FP64_1) return modesConst.maxSens;
-        return FP64_Exp(FP64_Mul(L, modesConst.logMot));
+static FP_LONG synchronous_legacy(const struct accel_params *params, FP_LONG x) {
+    if (params->modesConst.useClamp) {
+        FP_LONG L = FP64_Mul(params->modesConst.gammaConst, FP64_Sub(FP64_Log(x), params->modesConst.logSync));
+        if (L < FP64_1) return params->modesConst.minSens;
+        if (L > -FP64_1) return params->modesConst.maxSens;
+        return FP64_Exp(FP64_Mul(L, params->modesConst.logMot));
     }
 
-    if (x == g_Acceleration) {
+    if (x == params->Acceleration) {
         return FP64_1;
     }
 
-    FP_LONG delta = FP64_Sub(FP64_Log(x), modesConst.logSync);
-    FP_LONG M = FP64_Mul(modesConst.gammaConst, FP64_Abs(delta));
-    FP_LONG T = FP64_Tanh(FP64_Pow(M, modesConst.sharpness));
-    FP_LONG exponent = FP64_Pow(T, modesConst.sharpnessRecip);
+    FP_LONG delta = FP64_Sub(FP64_Log(x), params->modesConst.logSync);
+    FP_LONG M = FP64_Mul(params->modesConst.gammaConst, FP64_Abs(delta));
+    FP_LONG T = FP64_Tanh(FP64_Pow(M, params->modesConst.sharpness));
+    FP_LONG exponent = FP64_Pow(T, params->modesConst.sharpnessRecip);
     if (delta < 0) {
         exponent = -exponent;
     }
-    return FP64_Exp(FP64_Mul(exponent, modesConst.logMot));
+    return FP64_Exp(FP64_Mul(exponent, params->modesConst.logMot));
 }
 
 // Helper: build LUT for smoothing/gain mode
-static bool synchronous_build_lut(void) {
+static void synchronous_build_lut(struct accel_params *params) {
+    FP_LONG *data = params->modesConst.sync_lut;
+
     // x_start = 2^SYNC_START
-    s_sync_lut.x_start = FP64_Scalbn(FP64_1, SYNC_START);
+    params->modesConst.sync_x_start = FP64_Scalbn(FP64_1, SYNC_START);
 
     FP_LONG sum = 0;
     FP_LONG prev_x   = 0;
@@ -258,12 +282,12 @@ static bool synchronous_build_lut(void) {
                 // xi = a + p*interval
                 FP_LONG xi = FP64_Add(prev_x, FP64_Mul(FP64_FromInt(p), interval));
                 // sum += sync_legacy(xi) * interval
-                sum = FP64_Add(sum, FP64_Mul(synchronous_legacy(xi), interval));
+                sum = FP64_Add(sum, FP64_Mul(synchronous_legacy(params, xi), interval));
             }
 
             prev_x = b;
 
-            s_sync_lut.data[idx++] = sum;
+            data[idx++] = sum;
         }
     }
 
@@ -273,20 +297,21 @@ static bool synchronous_build_lut(void) {
         FP_LONG interval = FP64_DivPrecise(FP64_Sub(b, prev_x), FP64_FromInt(2));
         for (int p = 1; p <= 2; ++p) {
             FP_LONG xi = FP64_Add(prev_x, FP64_Mul(FP64_FromInt(p), interval));
-            sum = FP64_Add(sum, FP64_Mul(synchronous_legacy(xi), interval));
+            sum = FP64_Add(sum, FP64_Mul(synchronous_legacy(params, xi), interval));
         }
         prev_x = b;
 
         if (idx < SYNC_CAPACITY) {
-            s_sync_lut.data[idx] = sum; // last element
+            data[idx] = sum; // last element
         }
     }
 
-    s_sync_lut_ready = true;
-    return true;
+    params->modesConst.sync_start_sens = FP64_DivPrecise(data[0], params->modesConst.sync_x_start);
 }
 
-static FP_LONG synchronous_eval(FP_LONG x) {
+static FP_LONG synchronous_eval(const struct accel_params *params, FP_LONG x) {
+    const FP_LONG *data = params->modesConst.sync_lut;
+
     // Find octave index: e = floor(log2(x)), clamped
     int e = FP64_Ilogb(x);
     if (e < SYNC_START) e = SYNC_START;
@@ -309,60 +334,59 @@ static FP_LONG synchronous_eval(FP_LONG x) {
         // t = fractional part in [0,1)
         FP_LONG t = FP64_Sub(idxF, FP64_FromInt(idx));
 
-        FP_LONG y = FP64_Lerp(s_sync_lut.data[idx], s_sync_lut.data[idx + 1], t);
+        FP_LONG y = FP64_Lerp(data[idx], data[idx + 1], t);
 
         return FP64_DivPrecise(y, x);
     }
-    FP_LONG y = s_sync_lut.data[0];
-    return FP64_DivPrecise(y, s_sync_lut.x_start);
+    return params->modesConst.sync_start_sens;
 }
 
-FP_LONG accel_linear(FP_LONG speed) {
-    if (g_UseSmoothing) {
-        if (speed < modesConst.cap_x) {
-            speed = FP64_Mul(modesConst.sign, FP64_Mul(speed, g_Acceleration));
+FP_LONG accel_linear(const struct accel_params *params, FP_LONG speed) {
+    if (params->UseSmoothing) {
+        if (speed < params->modesConst.cap_x) {
+            speed = FP64_Mul(params->modesConst.sign, FP64_Mul(speed, params->Acceleration));
         } else {
-            speed = FP64_Mul(modesConst.sign, FP64_Add(FP64_DivPrecise(modesConst.gain_constant, speed), modesConst.cap_y));
+            speed = FP64_Mul(params->modesConst.sign, FP64_Add(FP64_DivPrecise(params->modesConst.gain_constant, speed), params->modesConst.cap_y));
         }
     } else {
-        speed = FP64_Mul(speed, g_Acceleration);
+        speed = FP64_Mul(speed, params->Acceleration);
     }
     return FP64_Add(FP64_1, speed);
 }
 
-FP_LONG accel_power(FP_LONG speed) {
-    if (speed <= modesConst.offset_x)
-        speed = g_Midpoint;
-    else if (modesConst.power_constant == 0)
-        speed = FP64_PowFast(FP64_Mul(speed, g_Acceleration), g_Exponent);
+FP_LONG accel_power(const struct accel_params *params, FP_LONG speed) {
+    if (speed <= params->modesConst.offset_x)
+        speed = params->Midpoint;
+    else if (params->modesConst.power_constant == 0)
+        speed = FP64_PowFast(FP64_Mul(speed, params->Acceleration), params->Exponent);
     else
-        speed = FP64_Add(FP64_PowFast(FP64_Mul(speed, g_Acceleration), g_Exponent), FP64_DivPrecise(modesConst.power_constant, speed));
+        speed = FP64_Add(FP64_PowFast(FP64_Mul(speed, params->Acceleration), params->Exponent), FP64_DivPrecise(params->modesConst.power_constant, speed));
     return speed;
 }
 
-FP_LONG accel_classic(FP_LONG speed) {
+FP_LONG accel_classic(const struct accel_params *params, FP_LONG speed) {
     // (Speed * Acceleration) ^ (Exponent - 1) + 1
     // Same as above just without adding the one
-    //speed *= g_Acceleration;
+    //speed *= params->Acceleration;
     //speed += 1;
-    //B_pow(&speed, &g_Exponent);
+    //B_pow(&speed, &params->Exponent);
 
     // FIXED-POINT:
     FP_LONG accel_classic_result = speed;
-    accel_classic_result = FP64_Mul(accel_classic_result, g_Acceleration);
-    accel_classic_result = FP64_PowFast(accel_classic_result, modesConst.exp_sub_1);
+    accel_classic_result = FP64_Mul(accel_classic_result, params->Acceleration);
+    accel_classic_result = FP64_PowFast(accel_classic_result, params->modesConst.exp_sub_1);
 
     // if Use Smooth Cap is on, we proceed to calculate the transition
     // point and the function that provides the smooth cap
-    if (g_UseSmoothing) {
+    if (params->UseSmoothing) {
         // we setup the y cap
-        if (speed < modesConst.cap_x) {
-            accel_classic_result = FP64_Mul(modesConst.sign, accel_classic_result);
+        if (speed < params->modesConst.cap_x) {
+            accel_classic_result = FP64_Mul(params->modesConst.sign, accel_classic_result);
             speed = FP64_Add(accel_classic_result, FP64_1);
         } else {
-            speed = FP64_Add(FP64_Mul(modesConst.sign,
-                                      FP64_Add(FP64_DivPrecise(modesConst.gain_constant, speed),
-                                               modesConst.cap_y)), FP64_1);
+            speed = FP64_Add(FP64_Mul(params->modesConst.sign,
+                                      FP64_Add(FP64_DivPrecise(params->modesConst.gain_constant, speed),
+                                               params->modesConst.cap_y)), FP64_1);
         }
     } else
         speed = FP64_Add(accel_classic_result, FP64_1);
@@ -370,77 +394,74 @@ FP_LONG accel_classic(FP_LONG speed) {
     return speed;
 }
 
-FP_LONG accel_motivity(FP_LONG speed) {
+FP_LONG accel_motivity(const struct accel_params *params, FP_LONG speed) {
     // Acceleration / ( 1 + e ^ (midpoint - x))
-    //product = g_Midpoint-speed;
+    //product = params->Midpoint-speed;
     //motivity = e;
     //B_pow(&motivity, &product);
-    //motivity = g_Acceleration / (1 + motivity);
+    //motivity = params->Acceleration / (1 + motivity);
     //speed = motivity;
 
     // FIXED-POINT:
-    FP_LONG exp = FP64_ExpFast(FP64_Sub(g_Midpoint, speed));
-    speed = FP64_Add(FP64_1, FP64_DivPrecise(modesConst.accel_sub_1, FP64_Add(FP64_1, exp)));
+    FP_LONG exp = FP64_ExpFast(FP64_Sub(params->Midpoint, speed));
+    speed = FP64_Add(FP64_1, FP64_DivPrecise(params->modesConst.accel_sub_1, FP64_Add(FP64_1, exp)));
     return speed;
 }
 
-FP_LONG accel_synchronous(FP_LONG speed) {
+FP_LONG accel_synchronous(const struct accel_params *params, FP_LONG speed) {
     // Defensive: ensure speed > 0 for log-domain math; you can clamp differently if your file already does.
     if (speed <= 0) {
         return FP64_1;
     }
 
     FP_LONG val;
-    if (g_UseSmoothing) {
-        if (!s_sync_lut_ready) { // This should be skipped 100% (except the first time) of the time by the branch predictor
-            synchronous_build_lut();
-        }
-        val = synchronous_eval(speed);
+    if (params->UseSmoothing) {
+        val = synchronous_eval(params, speed);
     } else {
-        val = synchronous_legacy(speed);
+        val = synchronous_legacy(params, speed);
     }
     return val;
 }
 
 
-FP_LONG accel_jump(FP_LONG speed) {
-    // r = 2pi/(k*midpoint), where k is the smoothness factor (stored inside g_Exponent)
+FP_LONG accel_jump(const struct accel_params *params, FP_LONG speed) {
+    // r = 2pi/(k*midpoint), where k is the smoothness factor (stored inside params->Exponent)
     // Jump: Acceleration / (1 + exp(r(midpoint - x))) + 1
     // Smooth: Integral of the above divided by x pretty much
 
-    FP_LONG exp_arg = FP64_Mul(modesConst.r, FP64_Sub(g_Midpoint, speed));
+    FP_LONG exp_arg = FP64_Mul(params->modesConst.r, FP64_Sub(params->Midpoint, speed));
     FP_LONG D = FP64_ExpFast(exp_arg);
 
-    if(g_UseSmoothing) { // smooth
+    if(params->UseSmoothing) { // smooth
         FP_LONG natural_log = exp_arg > (EXP_ARG_THRESHOLD << FP64_Shift) ? exp_arg : FP64_LogFast(FP64_Add(FP64_1, D));
-        FP_LONG integral = FP64_Mul(modesConst.accel_sub_1, FP64_Add(speed, FP64_DivPrecise(natural_log, modesConst.r)));
+        FP_LONG integral = FP64_Mul(params->modesConst.accel_sub_1, FP64_Add(speed, FP64_Mul(natural_log, params->modesConst.r_rcp)));
         // Not really an integral
-        speed = FP64_Add(FP64_DivPrecise(FP64_Sub(integral, modesConst.C0), speed), FP64_1);
+        speed = FP64_Add(FP64_DivPrecise(FP64_Sub(integral, params->modesConst.C0), speed), FP64_1);
     }
     else {
-        speed = FP64_Add(FP64_DivPrecise(modesConst.accel_sub_1, FP64_Add(FP64_1, D)), FP64_1);
+        speed = FP64_Add(FP64_DivPrecise(params->modesConst.accel_sub_1, FP64_Add(FP64_1, D)), FP64_1);
     }
     return speed;
 }
 
-FP_LONG accel_natural(FP_LONG speed) {
-    if (speed <= g_Midpoint) {
+FP_LONG accel_natural(const struct accel_params *params, FP_LONG speed) {
+    if (speed <= params->Midpoint) {
         speed = FP64_1;
     } else {
-        FP_LONG n_offset_x = FP64_Sub(g_Midpoint, speed);
-        FP_LONG decay = FP64_Exp(FP64_Mul(modesConst.auxiliar_accel, n_offset_x));
+        FP_LONG n_offset_x = FP64_Sub(params->Midpoint, speed);
+        FP_LONG decay = FP64_Exp(FP64_Mul(params->modesConst.auxiliar_accel, n_offset_x));
 
-        if (g_UseSmoothing) {
+        if (params->UseSmoothing) {
             FP_LONG decay_auxiliaraccel =
-                    FP64_DivPrecise(decay, modesConst.auxiliar_accel);
+                    FP64_Mul(decay, params->modesConst.auxiliar_accel_rcp);
             FP_LONG numerator = FP64_Add(
-                FP64_Mul(modesConst.exp_sub_1, FP64_Sub(decay_auxiliaraccel, n_offset_x)),
-                modesConst.auxiliar_constant);
+                FP64_Mul(params->modesConst.exp_sub_1, FP64_Sub(decay_auxiliaraccel, n_offset_x)),
+                params->modesConst.auxiliar_constant);
             speed = FP64_Add(FP64_DivPrecise(numerator, speed), FP64_1);
         } else {
             speed = FP64_Add(
-                FP64_Mul(modesConst.exp_sub_1, (FP64_Sub(
-                             FP64_1, FP64_DivPrecise(FP64_Sub(g_Midpoint, FP64_Mul(decay, n_offset_x)), speed)))),
+                FP64_Mul(params->modesConst.exp_sub_1, (FP64_Sub(
+                             FP64_1, FP64_DivPrecise(FP64_Sub(params->Midpoint, FP64_Mul(decay, n_offset_x)), speed)))),
                 FP64_1);
         }
     }
@@ -452,37 +473,251 @@ FP_LONG accel_natural(FP_LONG speed) {
 #define MIN(a,b) (((a)<(b))?(a):(b))
 #endif
 
-FP_LONG accel_lut(FP_LONG speed) {
-    // Assumes the size and values are valid. Please don't change LUT parameters by hand.
+// Fritsch-Carlson tangents for the monotone cubic. Assumes sorted x values.
+static void lut_build_tangents(struct accel_params *params) {
+    FP_LONG *m = params->modesConst.lut_tangent;
+    const FP_LONG *x = params->LutData_x, *y = params->LutData_y;
+    const int last = (int) params->LutSize - 1;
+    FP_LONG d_prev = 0;
+
+    for (int i = 0; i < last; i++) {
+        FP_LONG width = FP64_Sub(x[i + 1], x[i]);
+        // Slope of the segment. A step (repeated x) counts as flat, so the curve levels off on both sides of it
+        FP_LONG d = width > 0 ? FP64_DivPrecise(FP64_Sub(y[i + 1], y[i]), width) : 0;
+
+        if (i == 0)
+            m[i] = d;
+        else if (d_prev == 0 || d == 0 || (d_prev < 0) != (d < 0))
+            m[i] = 0; // Extremum or flat part, anything else would overshoot
+        else {
+            FP_LONG limit = 3 * MIN(FP64_Abs(d_prev), FP64_Abs(d));
 
-    if(speed < g_LutData_x[0]) // Check if the speed is below the first given point
-        speed = g_LutData_y[0];
-    else {
-        int l = 0, r = g_LutSize - 1, best_point = r, iter = 0; // We REALLY don't want an infinity loop in kernel
-        while (l <= r && iter < 10) {
-            int mid = (r + l) / 2;
-
-            if (speed > g_LutData_x[mid]) {
-                l = mid + 1;
-            } else {
-                best_point = mid;
-                r = mid - 1;
-            }
+            // Keeping both tangents of a segment within 3x its slope is enough for it to stay monotone. It's a bit
+            // stricter than the alpha^2 + beta^2 <= 9 circle, but needs no square root.
+            m[i] = d_prev / 2 + d / 2;
+            if (FP64_Abs(m[i]) > limit)
+                m[i] = d < 0 ? -limit : limit;
+        }
+        d_prev = d;
+    }
+    m[last] = d_prev;
+}
 
-            iter++;
+// Cubic Hermite segment 'seg' at t in [0, 1], in Horner form
+static FP_LONG lut_hermite(const struct accel_params *params, int seg, FP_LONG t, FP_LONG width) {
+    const FP_LONG *y = params->LutData_y, *m = params->modesConst.lut_tangent;
+    const FP_LONG d = FP64_DivPrecise(FP64_Sub(y[seg + 1], y[seg]), width);
+    const FP_LONG c2 = 3 * d - 2 * m[seg] - m[seg + 1];
+    const FP_LONG c3 = m[seg] + m[seg + 1] - 2 * d;
+
+    return FP64_Add(y[seg], FP64_Mul(FP64_Mul(width, t), FP64_Add(m[seg], FP64_Mul(t, FP64_Add(c2, FP64_Mul(t, c3))))));
+}
+
+// Samples the LUT at LUT_GRID_CELLS + 1 uniformly spaced speeds, linearly or along the monotone cubic between the points.
+// Assumes sorted x values.
+static void lut_build_grid(struct accel_params *params) {
+    struct ModesConstants *c = &params->modesConst;
+    const FP_LONG *x = params->LutData_x, *y = params->LutData_y;
+    const int last = (int) params->LutSize - 1;
+    const FP_LONG range = FP64_Sub(x[last], x[0]);
+    const bool cubic = params->LutInterpolation == LutInterp_MonotoneCubic;
+    FP_LONG width = FP64_Sub(x[last], x[last - 1]);
+    int seg = 0;
+
+    c->lut_x0 = x[0];
+    c->lut_scale = range > 0 ? FP64_DivPrecise(FP64_FromInt(LUT_GRID_CELLS), range) : 0;
+    c->lut_x_end = x[last];
+    c->lut_y_end = y[last];
+    c->lut_slope_end = width > 0 ? FP64_DivPrecise(FP64_Sub(y[last], y[last - 1]), width) : 0;
+
+    for (int i = 0; i <= LUT_GRID_CELLS; i++) {
+        // x[0] + range * i / LUT_GRID_CELLS, split so it can't overflow
+        FP_LONG gx = x[0] + (range >> LUT_GRID_BITS) * i + (((range & (LUT_GRID_CELLS - 1)) * i) >> LUT_GRID_BITS);
+
+        // A point exactly on a step (repeated x) takes the value before the step
+        while (seg < last - 1 && gx > x[seg + 1])
+            seg++;
+
+        width = FP64_Sub(x[seg + 1], x[seg]);
+        if (width > 0) {
+            FP_LONG t = FP64_DivPrecise(FP64_Sub(gx, x[seg]), width);
+            c->lut_grid[i] = cubic ? lut_hermite(params, seg, t, width) : FP64_Lerp(y[seg], y[seg + 1], t);
         }
+        else
+            c->lut_grid[i] = y[seg + 1];
+    }
+}
+
+FP_LONG accel_lut(const struct accel_params *params, FP_LONG speed) {
+    const struct ModesConstants *c = &params->modesConst;
+    FP_LONG pos;
+    int idx;
+
+    // Assumes the size and values are valid (the grid is built by update_constants()). Please don't change LUT parameters by hand.
+    if (params->LutSize < 2)
+        return FP64_1;
 
-        int index = MIN(best_point-1, g_LutSize-2);
+    if (speed <= c->lut_x0) // Below the first given point
+        return c->lut_grid[0];
+    if (speed >= c->lut_x_end) // Past the last one, the last segment goes on
+        return FP64_Add(c->lut_y_end, FP64_Mul(FP64_Sub(speed, c->lut_x_end), c->lut_slope_end));
 
-        FP_LONG p = g_LutData_y[index];
-        FP_LONG p1 = g_LutData_y[index + 1];
+    pos = FP64_Mul(FP64_Sub(speed, c->lut_x0), c->lut_scale);
+    idx = MIN((int) (pos >> FP64_Shift), LUT_GRID_CELLS - 1); // Rounding may land exactly on the end
 
-        // denominator should not possibly ever be equal to 0 here... (we all know how this will end)
-        FP_LONG frac = FP64_DivPrecise(speed - g_LutData_x[index],
-                                       g_LutData_x[index + 1] - g_LutData_x[index]);
+    return FP64_Lerp(c->lut_grid[idx], c->lut_grid[idx + 1], pos - ((FP_LONG) idx << FP64_Shift));
+}
 
-        speed = FP64_Lerp(p, p1, frac);
+FP_LONG accel_eval(const struct accel_params *params, FP_LONG speed) {
+    switch (params->AccelerationMode) {
+        case AccelMode_Linear:
+            return accel_linear(params, speed);
+        case AccelMode_Power:
+            return accel_power(params, speed);
+        case AccelMode_Classic:
+            return accel_classic(params, speed);
+        case AccelMode_Motivity:
+            return accel_motivity(params, speed);
+        case AccelMode_Synchronous:
+            return accel_synchronous(params, speed);
+        case AccelMode_Natural:
+            return accel_natural(params, speed);
+        case AccelMode_Jump:
+            return accel_jump(params, speed);
+        case AccelMode_Lut: case AccelMode_CustomCurve:
+            return accel_lut(params, speed);
+        default:
+            return FP64_1;
     }
+}
 
-    return speed;
+#define CURVE_TABLE_X_MIN (1ll << (FP64_Shift + CURVE_TABLE_OCTAVE_MIN))
+#define CURVE_TABLE_X_MAX (1ll << (FP64_Shift + CURVE_TABLE_OCTAVE_MAX))
+
+// Speed at the given table index: 2^e * (1 + i / CURVE_TABLE_RES)
+static FP_LONG curve_table_x(int idx) {
+    int e = (idx >> CURVE_TABLE_RES_BITS) + CURVE_TABLE_OCTAVE_MIN;
+    FP_LONG mantissa = FP64_1 + ((FP_LONG)(idx & (CURVE_TABLE_RES - 1)) << (FP64_Shift - CURVE_TABLE_RES_BITS));
+    return FP64_Scalbn(mantissa, e);
+}
+
+void curve_table_build(struct accel_params *params) {
+    struct curve_table *curve = &params->curve;
+
+    curve->valid = false;
+    curve->max_error = 0;
+
+    if (!params->UseCurveTable)
+        return;
+
+    // Only the transcendental modes are worth compiling. Linear is cheaper than a table lookup, and the LUT modes already are tables
+    switch (params->AccelerationMode) {
+        case AccelMode_Power: case AccelMode_Classic: case AccelMode_Motivity:
+        case AccelMode_Synchronous: case AccelMode_Natural: case AccelMode_Jump:
+            break;
+        default:
+            return;
+    }
+
+    for (int i = 0; i < CURVE_TABLE_SIZE; i++)
+        curve->data[i] = accel_eval(params, curve_table_x(i));
+
+    // The interpolation error of a smooth curve peaks around the middle of a cell
+    for (int i = 0; i < CURVE_TABLE_SIZE - 1; i++) {
+        FP_LONG x = FP64_Add(curve_table_x(i), curve_table_x(i + 1)) >> 1;
+        FP_LONG exact = accel_eval(params, x);
+        FP_LONG diff = FP64_Abs(FP64_Sub(FP64_Lerp(curve->data[i], curve->data[i + 1], FP64_0_5), exact));
+
+        if (exact != 0)
+            diff = FP64_DivPrecise(diff, FP64_Abs(exact));
+        if (diff > curve->max_error)
+            curve->max_error = diff;
+    }
+
+    curve->valid = true;
+}
+
+FP_LONG accel_curve_eval(const struct accel_params *params, FP_LONG speed) {
+    if (!params->curve.valid || speed < CURVE_TABLE_X_MIN || speed >= CURVE_TABLE_X_MAX)
+        return accel_eval(params, speed);
+
+    // The leading bit selects the octave, the next CURVE_TABLE_RES_BITS bits the cell, the rest is the lerp factor
+    FP_ULONG x = speed;
+    int msb = 63 - FP64_Nlz(x);
+    int shift = msb - CURVE_TABLE_RES_BITS;
+    int idx = ((msb - FP64_Shift - CURVE_TABLE_OCTAVE_MIN) << CURVE_TABLE_RES_BITS) + (int)(x >> shift) - CURVE_TABLE_RES;
+    FP_ULONG rem = x & ((1ull << shift) - 1);
+    FP_LONG t = (shift >= FP64_Shift) ? (FP_LONG)(rem >> (shift - FP64_Shift)) : (FP_LONG)(rem << (FP64_Shift - shift));
+
+    return FP64_Lerp(params->curve.data[idx], params->curve.data[idx + 1], t);
+}
+
+#ifndef __KERNEL__
+#define EVAL_BATCH(fn) for (size_t i = 0; i < n; i++) out[i] = fn(params, speeds[i])
+
+void accel_eval_batch(const struct accel_params *params, const FP_LONG *speeds, FP_LONG *out, size_t n) {
+    if (params->curve.valid) {
+        EVAL_BATCH(accel_curve_eval);
+        return;
+    }
+
+    switch (params->AccelerationMode) {
+        case AccelMode_Linear:
+            EVAL_BATCH(accel_linear);
+            break;
+        case AccelMode_Power:
+            EVAL_BATCH(accel_power);
+            break;
+        case AccelMode_Classic:
+            EVAL_BATCH(accel_classic);
+            break;
+        case AccelMode_Motivity:
+            EVAL_BATCH(accel_motivity);
+            break;
+        case AccelMode_Synchronous:
+            EVAL_BATCH(accel_synchronous);
+            break;
+        case AccelMode_Natural:
+            EVAL_BATCH(accel_natural);
+            break;
+        case AccelMode_Jump:
+            EVAL_BATCH(accel_jump);
+            break;
+        case AccelMode_Lut: case AccelMode_CustomCurve:
+            EVAL_BATCH(accel_lut);
+            break;
+        default:
+            for (size_t i = 0; i < n; i++)
+                out[i] = FP64_1;
+            break;
+    }
+}
+
+#undef EVAL_BATCH
+#endif
+
+accel_fn accel_select(const struct accel_params *params) {
+    if (params->curve.valid)
+        return accel_curve_eval;
+
+    switch (params->AccelerationMode) {
+        case AccelMode_Linear:
+            return accel_linear;
+        case AccelMode_Power:
+            return accel_power;
+        case AccelMode_Classic:
+            return accel_classic;
+        case AccelMode_Motivity:
+            return accel_motivity;
+        case AccelMode_Synchronous:
+            return accel_synchronous;
+        case AccelMode_Natural:
+            return accel_natural;
+        case AccelMode_Jump:
+            return accel_jump;
+        case AccelMode_Lut: case AccelMode_CustomCurve:
+            return accel_lut;
+        default:
+            return accel_eval;
+    }
 }
@@ -5,12 +5,29 @@
 #include <linux/module.h>
 #include "FixedMath/Fixed64.h"
 
-#define MAX_LUT_ARRAY_SIZE 128
-#define MAX_LUT_BUF_LEN 4096
+#define MAX_LUT_ARRAY_SIZE 4096
+#define MAX_LUT_BUF_LEN 4096 // A single write of LutDataBuf (a sysfs page), bigger LUTs are written in chunks
 
-struct ModesConstants {
-    bool is_init;
+// The LUT is resampled on update onto LUT_GRID_CELLS uniform cells between its first and last point,
+// so a lookup is a multiply, one pair of loads and a lerp
+#define LUT_GRID_BITS 12
+#define LUT_GRID_CELLS (1 << LUT_GRID_BITS)
+
+// Synchronous smoothing table, SYNC_NUM points per octave over [2^SYNC_START, 2^SYNC_STOP]
+#define SYNC_START (-3)
+#define SYNC_STOP (9)
+#define SYNC_NUM (8)
+#define SYNC_CAPACITY ((SYNC_STOP - SYNC_START) * SYNC_NUM + 1)
+
+// Compiled curve table. The grid is uniform within each octave (CURVE_TABLE_RES points per octave)
+// and spans speeds [2^CURVE_TABLE_OCTAVE_MIN, 2^CURVE_TABLE_OCTAVE_MAX). Speeds outside are evaluated directly.
+#define CURVE_TABLE_OCTAVE_MIN (-6)
+#define CURVE_TABLE_OCTAVE_MAX (12)
+#define CURVE_TABLE_RES_BITS 6
+#define CURVE_TABLE_RES (1 << CURVE_TABLE_RES_BITS)
+#define CURVE_TABLE_SIZE ((CURVE_TABLE_OCTAVE_MAX - CURVE_TABLE_OCTAVE_MIN) * CURVE_TABLE_RES + 1)
 
+struct ModesConstants {
     // Synchronous (legacy)
     FP_LONG logMot;
     FP_LONG gammaConst;
@@ -21,6 +38,11 @@ struct ModesConstants {
     FP_LONG minSens;
     FP_LONG maxSens;
 
+    // Synchronous (smooth), integral of the legacy curve. Built on update
+    FP_LONG sync_x_start;               // 2^SYNC_START
+    FP_LONG sync_start_sens;            // sync_lut[0] / sync_x_start, for speeds below the table
+    FP_LONG sync_lut[SYNC_CAPACITY];    // monotonic over x
+
     // Classic
     FP_LONG sign;
     FP_LONG gain_constant;
@@ -30,6 +52,7 @@ struct ModesConstants {
     // Jump
     FP_LONG C0; // the "integral" evaluated at 0
     FP_LONG r; // basically a smoothness factor
+    FP_LONG r_rcp;
 
     FP_LONG accel_sub_1;
     FP_LONG exp_sub_1;
@@ -40,20 +63,68 @@ struct ModesConstants {
 
     // Natural
     FP_LONG auxiliar_accel;
+    FP_LONG auxiliar_accel_rcp;
     FP_LONG auxiliar_constant;
 
-    // Rotation
-    FP_LONG sin_a, cos_a;
+    // LUT, resampled onto a uniform grid. Past the last point it continues along the last segment
+    FP_LONG lut_x0;                         // First point
+    FP_LONG lut_scale;                      // LUT_GRID_CELLS / (last x - first x), speed -> grid position
+    FP_LONG lut_x_end, lut_y_end;           // Last point
+    FP_LONG lut_slope_end;                  // Slope of the last segment
+    FP_LONG lut_grid[LUT_GRID_CELLS + 1];
+    FP_LONG lut_tangent[MAX_LUT_ARRAY_SIZE]; // dy/dx at every point, for LutInterp_MonotoneCubic only
+
+    // Output transform, rotation * diag(Sensitivity, SensitivityY). Without rotation and anisotropy it is
+    // just the sensitivity, which is then folded into the gain instead (gain_sens)
+    char use_transform;
+    FP_LONG gain_sens;
+    FP_LONG m_xx, m_xy, m_yx, m_yy;
 
     // Angle Snapping
-    FP_LONG as_sin, as_cos;
-    FP_LONG as_half_threshold;
+    FP_LONG as_dot_x, as_dot_y; // Snapping direction tested against the motion before the transform
+    FP_LONG as_out_x, as_out_y; // Snapping direction after the transform
+    FP_LONG as_cos_half_threshold;
+};
+
+struct curve_table {
+    bool valid;
+    FP_LONG max_error; // Max relative error against the direct evaluation, measured at the cell midpoints
+    FP_LONG data[CURVE_TABLE_SIZE];
+};
+
+// Parsed and validated acceleration parameters together with everything derived from them.
+// The driver builds a new instance in process context on every commit and publishes it as a whole,
+// so a published instance is never modified.
+struct accel_params {
+    char AccelerationMode;
+    char UseSmoothing;
+    char UseCurveTable;
+    char LutInterpolation;
+
+    FP_LONG InputCap;
+    FP_LONG Sensitivity;
+    FP_LONG SensitivityY;
+    FP_LONG OutputCap;
+    FP_LONG Offset;
+    FP_LONG PreScale;
+
+    FP_LONG Acceleration;
+    FP_LONG Exponent;
+    FP_LONG Midpoint;
+    FP_LONG Motivity;
+
+    FP_LONG RotationAngle;
+    FP_LONG AngleSnap_Threshold;
+    FP_LONG AngleSnap_Angle;
+
+    unsigned long LutSize;
+    FP_LONG LutData_x[MAX_LUT_ARRAY_SIZE];
+    FP_LONG LutData_y[MAX_LUT_ARRAY_SIZE];
+
+    struct ModesConstants modesConst;
+    struct curve_table curve;
 };
 
-extern FP_LONG g_Acceleration, g_Exponent, g_Midpoint, g_Motivity, g_RotationAngle, g_AngleSnap_Angle, g_AngleSnap_Threshold, g_LutData_x[], g_LutData_y[];
-extern char g_AccelerationMode, g_UseSmoothing;
-extern unsigned long g_LutSize;
-extern struct ModesConstants modesConst;
 static const FP_LONG FP64_PI =   C0NST_FP64_FromDouble(3.14159);
 static const FP_LONG FP64_PI_2 = C0NST_FP64_FromDouble(1.57079);
 static const FP_LONG FP64_PI_4 = C0NST_FP64_FromDouble(0.78539);
@@ -65,15 +136,57 @@ static const FP_LONG FP64_100     = 100ll << FP64_Shift;
 static const FP_LONG FP64_1000    = 1000ll << FP64_Shift;
 static const FP_LONG FP64_10000   = 10000ll << FP64_Shift;
 
-void update_constants(void);
+void update_constants(struct accel_params *params);
+
+FP_LONG accel_linear(const struct accel_params *params, FP_LONG speed);
+FP_LONG accel_power(const struct accel_params *params, FP_LONG speed);
+FP_LONG accel_classic(const struct accel_params *params, FP_LONG speed);
+FP_LONG accel_motivity(const struct accel_params *params, FP_LONG speed);
+FP_LONG accel_synchronous(const struct accel_params *params, FP_LONG speed);
+FP_LONG accel_natural(const struct accel_params *params, FP_LONG speed);
+FP_LONG accel_jump(const struct accel_params *params, FP_LONG speed);
+FP_LONG accel_lut(const struct accel_params *params, FP_LONG speed);
+
+// Evaluates the active mode directly
+FP_LONG accel_eval(const struct accel_params *params, FP_LONG speed);
+
+typedef FP_LONG (*accel_fn)(const struct accel_params *params, FP_LONG speed);
+
+// Samples the active mode into params->curve (if enabled and worth it for the mode). Call after update_constants()
+void curve_table_build(struct accel_params *params);
+// Evaluates the active mode through the compiled curve, falls back to accel_eval() when there is none or speed is out of its range
+FP_LONG accel_curve_eval(const struct accel_params *params, FP_LONG speed);
+// The cheapest function equivalent to accel_curve_eval() for the given parameters
+accel_fn accel_select(const struct accel_params *params);
+
+#ifndef __KERNEL__
+// out[i] = accel_select(params)(params, speeds[i]), the curve exactly as the driver evaluates it. For userspace (the GUI plots),
+// the mode is looked at once and each mode gets a loop of its own with the function called directly.
+void accel_eval_batch(const struct accel_params *params, const FP_LONG *speeds, FP_LONG *out, size_t n);
+#endif
+
+// Applies sensitivity, anisotropy and rotation to the motion (x, y) in one go
+static inline void accel_transform(const struct accel_params *params, FP_LONG *x, FP_LONG *y) {
+    FP_LONG new_x = FP64_Add(FP64_Mul(*x, params->modesConst.m_xx), FP64_Mul(*y, params->modesConst.m_xy));
+    *y = FP64_Add(FP64_Mul(*x, params->modesConst.m_yx), FP64_Mul(*y, params->modesConst.m_yy));
+    *x = new_x;
+}
+
+// Snaps the motion (x, y), taken before the transform, onto the snapping direction (either way) if it is within half the threshold of it.
+// mag is the length of the motion after diag(Sensitivity, SensitivityY), which is where the angle is measured. The angle itself
+// is never computed, only the dot product is compared against cos(threshold / 2) * mag.
+// Returns whether the motion was snapped, the snapped motion is already transformed.
+static inline bool angle_snap(const struct accel_params *params, FP_LONG *x, FP_LONG *y, FP_LONG mag) {
+    FP_LONG dot = FP64_Add(FP64_Mul(*x, params->modesConst.as_dot_x), FP64_Mul(*y, params->modesConst.as_dot_y));
+
+    if (FP64_Abs(dot) < FP64_Mul(params->modesConst.as_cos_half_threshold, mag))
+        return false;
 
-FP_LONG accel_linear(FP_LONG speed);
-FP_LONG accel_power(FP_LONG speed);
-FP_LONG accel_classic(FP_LONG speed);
-FP_LONG accel_motivity(FP_LONG speed);
-FP_LONG accel_synchronous(FP_LONG speed);
-FP_LONG accel_natural(FP_LONG speed);
-FP_LONG accel_jump(FP_LONG speed);
-FP_LONG accel_lut(FP_LONG speed);
+    if (dot < 0)
+        mag = -mag;
+    *x = FP64_Mul(params->modesConst.as_out_x, mag);
+    *y = FP64_Mul(params->modesConst.as_out_y, mag);
+    return true;
+}
 
 #endif //ACCEL_MODES_H
@@ -15,6 +15,7 @@
 #define MOTIVITY 1.5
 #define PRESCALE 1
 #define USE_SMOOTHING 1
+#define USE_CURVE_TABLE 0 // Evaluate the analytic modes through a table compiled on update (faster, but not exact)
 
 // Rotation (in radians)
 #define ROTATION_ANGLE 0
@@ -26,6 +27,7 @@
 // LUT settings
 #define LUT_SIZE 0
 #define LUT_DATA 0
+#define LUT_INTERPOLATION LutInterp_Linear // Or LutInterp_MonotoneCubic, smooth between the points
 
 
 #define ACCELERATION_MODE AccelMode_Linear
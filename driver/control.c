@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "control.h"
+#include "accel.h"
+#include "../shared_definitions.h"
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/fs.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/version.h>
+
+/* The struct is too big for the size field of an ioctl number, so its own header carries the size instead */
+static long control_set_config(struct yeetmouse_config __user *ucfg)
+{
+    struct yeetmouse_config *cfg;
+    u32 size, error = YEETMOUSE_CONFIG_OK;
+    long ret;
+
+    if (get_user(size, &ucfg->size))
+        return -EFAULT;
+    if (size != sizeof(*cfg))
+        return -EINVAL;
+
+    cfg = kvmalloc(sizeof(*cfg), GFP_KERNEL);
+    if (!cfg)
+        return -ENOMEM;
+
+    if (copy_from_user(cfg, ucfg, sizeof(*cfg))) {
+        ret = -EFAULT;
+        goto out;
+    }
+
+    ret = accel_set_config(cfg, &error);
+    if (put_user(error, &ucfg->error))
+        ret = -EFAULT;
+
+out:
+    kvfree(cfg);
+    return ret;
+}
+
+static long control_get_config(struct yeetmouse_config __user *ucfg)
+{
+    struct yeetmouse_config *cfg;
+    u32 size;
+    long ret;
+
+    if (get_user(size, &ucfg->size))
+        return -EFAULT;
+    if (size != sizeof(*cfg))
+        return -EINVAL;
+
+    cfg = kvmalloc(sizeof(*cfg), GFP_KERNEL);
+    if (!cfg)
+        return -ENOMEM;
+
+    ret = accel_get_config(cfg);
+    if (!ret && copy_to_user(ucfg, cfg, sizeof(*cfg)))
+        ret = -EFAULT;
+
+    kvfree(cfg);
+    return ret;
+}
+
+static long control_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+    switch (cmd) {
+    case YEETMOUSE_IOC_SET_CONFIG:
+        if (!(file->f_mode & FMODE_WRITE))
+            return -EBADF;
+        return control_set_config((struct yeetmouse_config __user *) arg);
+    case YEETMOUSE_IOC_GET_CONFIG:
+        return control_get_config((struct yeetmouse_config __user *) arg);
+    default:
+        return -ENOTTY;
+    }
+}
+
+static const struct file_operations control_fops = {
+    .owner = THIS_MODULE,
+    .unlocked_ioctl = control_ioctl,
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 5, 0))
+    // The config has the same layout for 32-bit processes, only the pointer needs converting
+    .compat_ioctl = compat_ptr_ioctl,
+#endif
+    .llseek = noop_llseek,
+};
+
+/* Root only, like the parameters in sysfs */
+static struct miscdevice control_device = {
+    .minor = MISC_DYNAMIC_MINOR,
+    .name = "yeetmouse_control",
+    .fops = &control_fops,
+    .mode = 0600,
+};
+
+int control_init(void)
+{
+    return misc_register(&control_device);
+}
+
+void control_exit(void)
+{
+    misc_deregister(&control_device);
+}
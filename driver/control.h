@@ -0,0 +1,10 @@
+#ifndef _CONTROL_H
+#define _CONTROL_H
+
+/* Binary configuration through ioctl()s on /dev/yeetmouse_control (see struct yeetmouse_config in shared_definitions.h).
+ * A whole configuration is checked and published at once, instead of parameter by parameter through sysfs. */
+
+int control_init(void);
+void control_exit(void);
+
+#endif /* _CONTROL_H */
@@ -1,6 +1,10 @@
 #include "accel.h"
 #include "config.h"
 #include "util.h"
+#include "stats.h"
+#include "motion_ring.h"
+#include "control.h"
+#include "../shared_definitions.h"
 
 #include <linux/kernel.h>
 #include <linux/slab.h>
@@ -18,12 +22,84 @@
 #define __cleanup_events 1
 #endif
 
+/* Per-handle state. Cache-line aligned, so two devices handled on different CPUs never write to the same line. */
 struct mouse_state {
-    int x;
-    int y;
-    int wheel;
-};
+    struct accel_state accel;
+    ktime_t timestamp;  /* Timestamp of the previous frame */
+    u32 msc;            /* MSC_TIMESTAMP of the current frame (in us, wraps around) */
+    u32 last_msc;       /* MSC_TIMESTAMP of the previous frame */
+    bool has_msc;       /* The current frame carries an MSC_TIMESTAMP */
+    bool msc_valid;     /* The previous frame carried one too, so the device's clock can be used */
+    u32 device;         /* N of inputN, for the readers of the motion ring */
+#ifdef CONFIG_YEETMOUSE_STATS
+    struct yeetmouse_stats *stats;
+#endif
+} ____cacheline_aligned;
+
+/* Timestamp of the current frame. The device's own MSC_TIMESTAMP is preferred, as it measures when the device reported
+ * rather than when the handler ran. Otherwise, the input core's timestamp of the frame is used (set by the device driver,
+ * or taken once and shared with all the other handlers, like evdev). ktime_get() is only a fallback for old kernels. */
+static ktime_t frame_timestamp(struct mouse_state *state, struct input_dev *dev) {
+    ktime_t now;
+
+    if (state->has_msc && state->msc_valid) {
+        now = ktime_add_us(state->timestamp, (u32) (state->msc - state->last_msc));
+    } else {
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 4, 0))
+        now = input_get_timestamp(dev)[INPUT_CLK_MONO];
+#else
+        now = ktime_get();
+#endif
+    }
+
+    if (state->timestamp && now > state->timestamp)
+        stats_record(state->stats, STATS_FRAME_DT, now - state->timestamp);
+
+    state->msc_valid = state->has_msc;
+    state->last_msc = state->msc;
+    state->has_msc = false;
+    state->timestamp = now;
+
+    return now;
+}
+
+/* Writes the accelerated values into the frame's REL events (out[0, count)) and returns the new frame length.
+ * With __cleanup_events, events whose value became 0 are dropped, older kernels can't change the number of events. */
+static unsigned int apply_frame(struct input_value *out, unsigned int count, int x, int y, int wheel) {
+    unsigned int i, end = 0;
+
+    for (i = 0; i < count; i++) {
+        if (out[i].type == EV_REL) {
+            switch (out[i].code) {
+                case REL_X:
+                    if (__cleanup_events && x == NONE_EVENT_VALUE)
+                        continue;
+                    out[i].value = x;
+                    break;
+                case REL_Y:
+                    if (__cleanup_events && y == NONE_EVENT_VALUE)
+                        continue;
+                    out[i].value = y;
+                    break;
+                case REL_WHEEL:
+                    if (__cleanup_events && wheel == NONE_EVENT_VALUE)
+                        continue;
+                    out[i].value = wheel;
+                    break;
+            }
+        }
+        if (end != i)
+            out[end] = out[i];
+        end++;
+    }
+
+    return end;
+}
 
+/* Single forward pass over the batch. Events are compacted in place while the REL values of the current frame are
+ * collected, and every frame is accelerated at its own SYN_REPORT. Only that frame's few events (which are still hot)
+ * are patched afterwards, so any number of frames per batch is handled at its own point in time.
+ * The input core always ends a batch with SYN_REPORT, anything after the last one is passed through untouched. */
 #if __cleanup_events
 static unsigned int driver_events(struct input_handle *handle, struct input_value *vals, unsigned int count) {
 #else
@@ -31,132 +107,57 @@ static unsigned int driver_events(struct input_handle *handle, struct input_valu
 #endif
     struct mouse_state *state = handle->private;
     struct input_dev *dev = handle->dev;
-    unsigned int out_count = count;
-    struct input_value *v_syn = NULL;
-    struct input_value *end = (struct input_value *) vals;
-    struct input_value *v;
-    int error;
+    struct input_value *out = (struct input_value *) vals;
+    unsigned int i, end = 0, frame = 0;
+    int x = NONE_EVENT_VALUE, y = NONE_EVENT_VALUE, wheel = NONE_EVENT_VALUE;
+    u64 __maybe_unused start = stats_clock();
+
+    for (i = 0; i < count; i++) {
+        const struct input_value v = out[i];
+
+        if (end != i)
+            out[end] = v;
+        end++;
 
-    for (v = (struct input_value *) vals; v != vals + count; v++) {
-        if (v->type == EV_REL) {
-            /* Find input_value for EV_REL events we're interested in and store values */
-            switch (v->code) {
+        if (v.type == EV_REL) {
+            switch (v.code) {
                 case REL_X:
-                    state->x = (int) v->value;
+                    x = v.value;
                     break;
                 case REL_Y:
-                    state->y = (int) v->value;
+                    y = v.value;
                     break;
                 case REL_WHEEL:
-                    state->wheel = (int) v->value;
+                    wheel = v.value;
                     break;
             }
-        } else if (
-            (state->x != NONE_EVENT_VALUE || state->y != NONE_EVENT_VALUE) &&
-            v->type == EV_SYN && v->code == SYN_REPORT
-        ) {
-            /* If we find an EV_SYN event, and we've seen x/y values, we store the pointer and apply acceleration next */
-            v_syn = v;
-            break;
-        }
-    }
-
-    if (v_syn != NULL) {
-        /* Retrieve to state if an EV_SYN event was found and apply acceleration */
-        int x = state->x;
-        int y = state->y;
-        int wheel = state->wheel;
-        /* If we found no values to update, return */
-        if (x == NONE_EVENT_VALUE && y == NONE_EVENT_VALUE && wheel == NONE_EVENT_VALUE)
-            goto unchanged_return;
-        error = accelerate(&x, &y, &wheel);
-        /* Reset state */
-        state->x = NONE_EVENT_VALUE;
-        state->y = NONE_EVENT_VALUE;
-        state->wheel = NONE_EVENT_VALUE;
-        /* Deal with left over EV_REL events we should take into account for the next run */
-        for (v = v_syn; v != vals + count; v++) {
-            if (v->type == EV_REL) {
-                /* Store values for next runthrough */
-                switch (v->code) {
-                    case REL_X:
-                        state->x = v->value;
-                        break;
-                    case REL_Y:
-                        state->y = v->value;
-                        break;
-                    case REL_WHEEL:
-                        state->wheel = v->value;
-                        break;
-                }
+        } else if (v.type == EV_MSC && v.code == MSC_TIMESTAMP) {
+            state->msc = (u32) v.value;
+            state->has_msc = true;
+        } else if (v.type == EV_SYN && v.code == SYN_REPORT) {
+            /* Frames without motion (buttons, wheel only) are left alone */
+            if (x != NONE_EVENT_VALUE || y != NONE_EVENT_VALUE) {
+                ktime_t now = frame_timestamp(state, dev);
+                const int raw_x = x, raw_y = y;
+                u64 __maybe_unused accel_start = stats_clock();
+                int status = accelerate(&state->accel, now, &x, &y, &wheel);
+
+                stats_record(state->stats, STATS_ACCELERATE, stats_clock() - accel_start);
+                if (motion_ring_enabled() && !status)
+                    motion_ring_push(state->device, now, raw_x, raw_y, state->accel.speed, state->accel.gain);
+                if (!status)
+                    end = frame + apply_frame(out + frame, end - frame, x, y, wheel);
             }
-        }
-        /* Apply updates after we've captured events for next run */
-        if (!error) {
-            for (v = (struct input_value *) vals; v != vals + count; v++) {
-                if (v->type == EV_REL) {
-                    switch (v->code) {
-                        case REL_X:
-                            if (__cleanup_events && x == NONE_EVENT_VALUE)
-                                continue;
-                            v->value = x;
-                            break;
-                        case REL_Y:
-                            if (__cleanup_events && y == NONE_EVENT_VALUE)
-                                continue;
-                            v->value = y;
-                            break;
-                        case REL_WHEEL:
-                            if (__cleanup_events && wheel == NONE_EVENT_VALUE)
-                                continue;
-                            v->value = wheel;
-                            break;
-                    }
-                }
-                if (end != v)
-                    *end = *v;
-                end++;
-            }
-            out_count = end - vals;
-            /* Apply new values to the queued (raw) events, same as above.
-             * NOTE: This might (strictly speaking) not be necessary, but this way we leave
-             * no trace of the unmodified values, in case another subsystem uses them. */
-            for (v = (struct input_value *) vals; v != vals + count; v++) {
-                if (v->type == EV_REL) {
-                    switch (v->code) {
-                        case REL_X:
-                            if (x == NONE_EVENT_VALUE)
-                                continue;
-                            v->value = x;
-                            break;
-                        case REL_Y:
-                            if (y == NONE_EVENT_VALUE)
-                                continue;
-                            v->value = y;
-                            break;
-                        case REL_WHEEL:
-                            if (wheel == NONE_EVENT_VALUE)
-                                continue;
-                            v->value = wheel;
-                            break;
-                    }
-                }
-                if (end != v)
-                    *end = *v;
-                end++;
-            }
-            dev->num_vals = end - vals;
+
+            x = y = wheel = NONE_EVENT_VALUE;
+            frame = end;
         }
     }
-    /* NOTE: Technically, we can also stop iterating over `vals` when we find EV_SYN, apply acceleration,
-     * then restart in a loop until we reach the end of `vals` to handle multiple EV_SYN events per batch.
-     * However, that's not necessary since we can assume that all events in `vals` apply to the same moment
-     * in time. */
-unchanged_return:
+
+    stats_record(state->stats, STATS_HANDLER, stats_clock() - start);
+
 #if __cleanup_events
-    return out_count;
-#else
-  return;
+    return end;
 #endif
 }
 
@@ -220,9 +221,13 @@ static int driver_connect(struct input_handler *handler, struct input_dev *dev,
         return -ENOMEM;
     }
 
-    state->x = NONE_EVENT_VALUE;
-    state->y = NONE_EVENT_VALUE;
-    state->wheel = NONE_EVENT_VALUE;
+    accel_state_init(&state->accel);
+    state->accel.name = dev_name(&dev->dev);
+    if (strncmp(state->accel.name, "input", 5) || kstrtouint(state->accel.name + 5, 10, &state->device))
+        state->device = MOTION_RECORD_NO_DEVICE;
+#ifdef CONFIG_YEETMOUSE_STATS
+    state->stats = stats_create(dev_name(&dev->dev));
+#endif
 
     handle->private = state;
     handle->dev = input_get_device(dev);
@@ -249,15 +254,19 @@ err_unregister_handle:
     input_unregister_handle(handle);
 
 err_free_mem:
+    stats_destroy(state->stats);
     kfree(handle->private);
     kfree(handle);
     return error;
 }
 
 static void driver_disconnect(struct input_handle *handle) {
+    struct mouse_state *state = handle->private;
+
     input_close_device(handle);
     input_unregister_handle(handle);
-    kfree(handle->private);
+    stats_destroy(state->stats);
+    kfree(state);
     kfree(handle);
 }
 
@@ -281,11 +290,47 @@ struct input_handler driver_handler = {
 };
 
 static int __init yeetmouse_init(void) {
-    return input_register_handler(&driver_handler);
+    int error = accel_init();
+    if (error)
+        return error;
+
+    error = stats_init();
+    if (error)
+        goto err_accel_exit;
+
+    error = motion_ring_init();
+    if (error)
+        goto err_stats_exit;
+
+    error = control_init();
+    if (error)
+        goto err_motion_ring_exit;
+
+    error = input_register_handler(&driver_handler);
+    if (error)
+        goto err_control_exit;
+    return 0;
+
+err_control_exit:
+    control_exit();
+
+err_motion_ring_exit:
+    motion_ring_exit();
+
+err_stats_exit:
+    stats_exit();
+
+err_accel_exit:
+    accel_exit();
+    return error;
 }
 
 static void __exit yeetmouse_exit(void) {
     input_unregister_handler(&driver_handler);
+    control_exit();
+    motion_ring_exit();
+    stats_exit();
+    accel_exit();
 }
 
 MODULE_DESCRIPTION("USB HID input handler applying mouse acceleration (Yeetmouse)");
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "health.h"
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/string.h>
+
+DEFINE_PER_CPU(struct health_counters, g_health);
+
+static const char *const g_health_names[HEALTH_COUNT] = {
+    [HEALTH_FRAMES] = "frames",
+    [HEALTH_DT_CLAMP] = "dt_clamp",
+    [HEALTH_INPUT_CAP] = "input_cap",
+    [HEALTH_OUTPUT_CAP] = "output_cap",
+    [HEALTH_LUT_RANGE] = "lut_out_of_range",
+    [HEALTH_MODE_FALLBACK] = "mode_fallback",
+    [HEALTH_CARRY_OVERFLOW] = "carry_overflow",
+};
+
+/* One "name: count" line per counter. Other CPUs may be counting meanwhile, so it's a close enough snapshot */
+static int health_get(char *buffer, const struct kernel_param *kp)
+{
+    int len = 0, cpu, i;
+
+    for (i = 0; i < HEALTH_COUNT; i++) {
+        u64 total = 0;
+
+        for_each_possible_cpu(cpu)
+            total += READ_ONCE(per_cpu(g_health, cpu).count[i]);
+        len += scnprintf(buffer + len, PAGE_SIZE - len, "%s: %llu\n", g_health_names[i], total);
+    }
+
+    return len;
+}
+
+static int health_set(const char *val, const struct kernel_param *kp)
+{
+    int cpu;
+
+    for_each_possible_cpu(cpu)
+        memset(per_cpu_ptr(&g_health, cpu), 0, sizeof(struct health_counters));
+
+    return 0;
+}
+
+static const struct kernel_param_ops health_ops = {
+    .set = health_set,
+    .get = health_get,
+};
+
+module_param_cb(Health, &health_ops, NULL, 0644);
+MODULE_PARM_DESC(Health, "Counters of the clamps and fallbacks in the acceleration (any write resets them)");
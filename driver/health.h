@@ -0,0 +1,31 @@
+#ifndef _HEALTH_H
+#define _HEALTH_H
+
+#include <linux/types.h>
+#include <linux/percpu.h>
+
+/* Counters of the places where the pipeline clamps or falls back, to tell whether a profile works in its intended range.
+ * They are per-CPU (no shared cache line on the event path) and summed up on a read of
+ * /sys/module/yeetmouse/parameters/Health. Any write to it resets them. */
+
+enum health_counter {
+    HEALTH_FRAMES,          /* Frames accelerated (not the ones of the Benchmark parameter) */
+    HEALTH_DT_CLAMP,        /* Frame time out of (0, 100] ms, e.g. the first frame after a pause */
+    HEALTH_INPUT_CAP,       /* Speed cut by InputCap */
+    HEALTH_OUTPUT_CAP,      /* Gain cut by OutputCap */
+    HEALTH_LUT_RANGE,       /* LUT lookup outside of the given points (clamped below, extrapolated above) */
+    HEALTH_MODE_FALLBACK,   /* Update that couldn't use the requested mode and fell back to AccelMode_Current */
+    HEALTH_CARRY_OVERFLOW,  /* Motion that didn't fit into an int, the sub-pixel carry is dropped */
+    HEALTH_COUNT
+};
+
+struct health_counters {
+    u64 count[HEALTH_COUNT];
+};
+
+DECLARE_PER_CPU(struct health_counters, g_health);
+
+/* Safe from any context, even with preemption on */
+#define health_inc(which) this_cpu_inc(g_health.count[which])
+
+#endif /* _HEALTH_H */
@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "motion_ring.h"
+#include "../shared_definitions.h"
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/miscdevice.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/vmalloc.h>
+#include <linux/version.h>
+
+DEFINE_STATIC_KEY_FALSE(motion_ring_active);
+
+static struct motion_ring *g_ring;
+static DEFINE_MUTEX(g_ring_lock);       /* Allocation of the ring */
+static DEFINE_SPINLOCK(g_ring_writer);  /* Devices handled on different CPUs */
+
+#define MOTION_RING_BYTES (sizeof(struct motion_ring) + MOTION_RING_SIZE * sizeof(struct motion_record))
+
+static int motion_open(struct inode *inode, struct file *file)
+{
+    mutex_lock(&g_ring_lock);
+    if (!g_ring) {
+        /* Zeroed and page aligned, so it can be mapped as it is */
+        struct motion_ring *ring = vmalloc_user(MOTION_RING_BYTES);
+
+        if (!ring) {
+            mutex_unlock(&g_ring_lock);
+            return -ENOMEM;
+        }
+        ring->magic = MOTION_RING_MAGIC;
+        ring->version = MOTION_RING_VERSION;
+        ring->size = MOTION_RING_SIZE;
+        ring->record_size = sizeof(struct motion_record);
+        g_ring = ring;
+    }
+    mutex_unlock(&g_ring_lock);
+
+    static_branch_inc(&motion_ring_active);
+    return 0;
+}
+
+static int motion_release(struct inode *inode, struct file *file)
+{
+    /* Existing mappings keep working, the ring just stops moving once the last reader is gone */
+    static_branch_dec(&motion_ring_active);
+    return 0;
+}
+
+static int motion_mmap(struct file *file, struct vm_area_struct *vma)
+{
+    if (vma->vm_flags & VM_WRITE)
+        return -EPERM;
+
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0))
+    vm_flags_clear(vma, VM_MAYWRITE);
+#else
+    vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+
+    return remap_vmalloc_range(vma, g_ring, vma->vm_pgoff);
+}
+
+static const struct file_operations motion_fops = {
+    .owner = THIS_MODULE,
+    .open = motion_open,
+    .release = motion_release,
+    .mmap = motion_mmap,
+    .llseek = noop_llseek,
+};
+
+static struct miscdevice motion_device = {
+    .minor = MISC_DYNAMIC_MINOR,
+    .name = "yeetmouse_motion",
+    .fops = &motion_fops,
+};
+
+int motion_ring_init(void)
+{
+    return misc_register(&motion_device);
+}
+
+void motion_ring_exit(void)
+{
+    /* No more opens, and the handler is already unregistered, so no more writers either */
+    misc_deregister(&motion_device);
+    vfree(g_ring);
+    g_ring = NULL;
+}
+
+void motion_ring_push(u32 device, u64 timestamp, int dx, int dy, s64 speed, s64 gain)
+{
+    struct motion_record *record;
+    unsigned long flags;
+    u64 n;
+
+    spin_lock_irqsave(&g_ring_writer, flags);
+
+    n = g_ring->head;
+    record = &g_ring->records[n & (MOTION_RING_SIZE - 1)];
+
+    /* Readers that see the old 'seq' before the copy and after it know the record didn't change in between */
+    WRITE_ONCE(record->seq, 0);
+    smp_wmb();
+    record->timestamp = timestamp;
+    record->dx = dx;
+    record->dy = dy;
+    record->speed = speed;
+    record->gain = gain;
+    record->device = device;
+    smp_store_release(&record->seq, n + 1);
+    smp_store_release(&g_ring->head, n + 1);
+
+    spin_unlock_irqrestore(&g_ring_writer, flags);
+}
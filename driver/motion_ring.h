@@ -0,0 +1,21 @@
+#ifndef _MOTION_RING_H
+#define _MOTION_RING_H
+
+#include <linux/types.h>
+#include <linux/jump_label.h>
+
+/* Live motion samples for visualization, through a read-only mmap() of /dev/yeetmouse_motion (see struct motion_ring in
+ * shared_definitions.h). The ring is allocated on the first open and kept until the module is unloaded. While nobody has
+ * the device open the key is off, and the event handler pays nothing but a patched out branch. */
+
+DECLARE_STATIC_KEY_FALSE(motion_ring_active);
+
+#define motion_ring_enabled() static_branch_unlikely(&motion_ring_active)
+
+int motion_ring_init(void);
+void motion_ring_exit(void);
+
+/* Safe from any context, the writers of different devices are serialized. Readers never take the lock. */
+void motion_ring_push(u32 device, u64 timestamp, int dx, int dy, s64 speed, s64 gain);
+
+#endif /* _MOTION_RING_H */
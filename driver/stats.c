@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "stats.h"
+
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
+
+static struct dentry *g_stats_root;
+
+static const char *const g_hist_names[STATS_HIST_COUNT] = {
+    [STATS_HANDLER] = "handler_ns",
+    [STATS_ACCELERATE] = "accelerate_ns",
+    [STATS_FRAME_DT] = "frame_dt_ns",
+};
+
+/* Upper bound of the given bucket */
+static u64 bucket_limit(int bucket)
+{
+    return bucket == 0 ? 0 : (bucket >= STATS_BUCKETS - 1 ? U64_MAX : (1ull << bucket) - 1);
+}
+
+static int hist_show(struct seq_file *m, void *v)
+{
+    const struct stats_file *file = m->private;
+    static const unsigned int percentiles[] = {500, 900, 990, 999}; /* In tenths of a percent */
+    struct stats_hist_data total = {};
+    u64 samples = 0, seen = 0;
+    unsigned int p = 0;
+    int cpu, i;
+
+    /* Updates may be running on other CPUs, so this is only a close enough snapshot */
+    for_each_possible_cpu(cpu) {
+        const struct stats_hist_data *hist = &per_cpu_ptr(file->stats->cpu, cpu)->hist[file->which];
+
+        for (i = 0; i < STATS_BUCKETS; i++)
+            total.buckets[i] += READ_ONCE(hist->buckets[i]);
+        total.sum += READ_ONCE(hist->sum);
+        total.max = max(total.max, READ_ONCE(hist->max));
+    }
+
+    for (i = 0; i < STATS_BUCKETS; i++)
+        samples += total.buckets[i];
+
+    seq_printf(m, "samples: %llu\n", samples);
+    if (samples == 0)
+        return 0;
+
+    seq_printf(m, "mean: %llu\n", div64_u64(total.sum, samples));
+    seq_printf(m, "max: %llu\n", total.max);
+
+    /* Percentiles are the upper bound of the bucket they fall into */
+    for (i = 0; i < STATS_BUCKETS && p < ARRAY_SIZE(percentiles); i++) {
+        seen += total.buckets[i];
+        while (p < ARRAY_SIZE(percentiles) && seen * 1000 >= samples * percentiles[p]) {
+            if (percentiles[p] % 10)
+                seq_printf(m, "p%u.%u: <= %llu\n", percentiles[p] / 10, percentiles[p] % 10,
+                           min(bucket_limit(i), total.max));
+            else
+                seq_printf(m, "p%u: <= %llu\n", percentiles[p] / 10, min(bucket_limit(i), total.max));
+            p++;
+        }
+    }
+
+    seq_puts(m, "\n");
+    for (i = 0; i < STATS_BUCKETS; i++) {
+        if (total.buckets[i])
+            seq_printf(m, "%llu - %llu: %llu\n", i == 0 ? 0 : 1ull << (i - 1), bucket_limit(i), total.buckets[i]);
+    }
+
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(hist);
+
+/* Any write to "reset" clears all the histograms of the device */
+static ssize_t reset_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
+{
+    struct yeetmouse_stats *stats = file->private_data;
+    int cpu;
+
+    for_each_possible_cpu(cpu)
+        memset(per_cpu_ptr(stats->cpu, cpu), 0, sizeof(struct stats_cpu));
+
+    return count;
+}
+
+static const struct file_operations reset_fops = {
+    .owner = THIS_MODULE,
+    .open = simple_open,
+    .write = reset_write,
+    .llseek = noop_llseek,
+};
+
+int stats_init(void)
+{
+    /* Debugfs failures are not fatal (and it may not be enabled at all), the files just won't be there */
+    g_stats_root = debugfs_create_dir("yeetmouse", NULL);
+    return 0;
+}
+
+void stats_exit(void)
+{
+    debugfs_remove_recursive(g_stats_root);
+}
+
+struct yeetmouse_stats *stats_create(const char *name)
+{
+    struct yeetmouse_stats *stats;
+    int i;
+
+    stats = kzalloc(sizeof(*stats), GFP_KERNEL);
+    if (!stats)
+        return NULL;
+
+    stats->cpu = alloc_percpu(struct stats_cpu);
+    if (!stats->cpu) {
+        kfree(stats);
+        return NULL;
+    }
+
+    stats->dir = debugfs_create_dir(name, g_stats_root);
+    for (i = 0; i < STATS_HIST_COUNT; i++) {
+        stats->files[i].stats = stats;
+        stats->files[i].which = i;
+        debugfs_create_file(g_hist_names[i], 0444, stats->dir, &stats->files[i], &hist_fops);
+    }
+    debugfs_create_file("reset", 0200, stats->dir, stats, &reset_fops);
+
+    return stats;
+}
+
+void stats_destroy(struct yeetmouse_stats *stats)
+{
+    if (!stats)
+        return;
+
+    /* Waits for the readers and writers of the files still in progress */
+    debugfs_remove_recursive(stats->dir);
+    free_percpu(stats->cpu);
+    kfree(stats);
+}
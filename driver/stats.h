@@ -0,0 +1,82 @@
+#ifndef _STATS_H
+#define _STATS_H
+
+#include <linux/types.h>
+
+/* Per-device latency histograms under /sys/kernel/debug/yeetmouse/<input device>/.
+ * Only built with CONFIG_YEETMOUSE_STATS (make driver CONFIG_YEETMOUSE_STATS=y), otherwise every call below compiles
+ * to nothing and the arguments are never evaluated. */
+
+enum stats_hist {
+    STATS_HANDLER,      /* Whole driver_events() call */
+    STATS_ACCELERATE,   /* accelerate() of a single frame */
+    STATS_FRAME_DT,     /* Time between two frames with motion */
+    STATS_HIST_COUNT
+};
+
+#ifdef CONFIG_YEETMOUSE_STATS
+
+#include <linux/percpu.h>
+#include <linux/timekeeping.h>
+#include <linux/bitops.h>
+
+/* Bucket i counts the values in [2^(i-1), 2^i) ns, bucket 0 counts zeros. Anything from 2^62 up ends in the last one. */
+#define STATS_BUCKETS 64
+
+struct stats_hist_data {
+    u64 buckets[STATS_BUCKETS];
+    u64 sum;
+    u64 max;
+};
+
+struct stats_cpu {
+    struct stats_hist_data hist[STATS_HIST_COUNT];
+};
+
+struct stats_file {
+    struct yeetmouse_stats *stats;
+    enum stats_hist which;
+};
+
+struct yeetmouse_stats {
+    struct stats_cpu __percpu *cpu;
+    struct dentry *dir;
+    struct stats_file files[STATS_HIST_COUNT];
+};
+
+int stats_init(void);
+void stats_exit(void);
+
+/* NULL when out of memory, the device then just isn't tracked */
+struct yeetmouse_stats *stats_create(const char *name);
+void stats_destroy(struct yeetmouse_stats *stats);
+
+#define stats_clock() ktime_get_ns()
+
+/* Called from the event handler, which runs with interrupts off, so this CPU's histogram is ours alone */
+static inline void stats_record(struct yeetmouse_stats *stats, enum stats_hist which, u64 ns)
+{
+    struct stats_hist_data *hist;
+
+    if (!stats)
+        return;
+
+    hist = &this_cpu_ptr(stats->cpu)->hist[which];
+    hist->buckets[min(fls64(ns), STATS_BUCKETS - 1)]++;
+    hist->sum += ns;
+    if (ns > hist->max)
+        hist->max = ns;
+}
+
+#else
+
+#define stats_init() 0
+#define stats_exit() do { } while (0)
+#define stats_create(name) NULL
+#define stats_destroy(stats) do { } while (0)
+#define stats_clock() 0
+#define stats_record(stats, which, ns) do { } while (0)
+
+#endif /* CONFIG_YEETMOUSE_STATS */
+
+#endif /* _STATS_H */
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM yeetmouse
+
+#if !defined(_YEETMOUSE_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _YEETMOUSE_TRACE_H
+
+#include <linux/tracepoint.h>
+#include <linux/version.h>
+#include "FixedMath/Fixed64.h"
+
+// 6.10 dropped the source argument, the string is taken from the one given to __string()
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6, 10, 0))
+#define yeetmouse_assign_str(dst, src) __assign_str(dst)
+#else
+#define yeetmouse_assign_str(dst, src) __assign_str(dst, src)
+#endif
+
+// Q32.32 as a signed decimal with 6 fractional digits (plain arithmetic, so trace-cmd and perf can format it too)
+#define YEETMOUSE_FP_FMT "%s%llu.%06llu"
+#define YEETMOUSE_FP_ABS(v) ((u64) ((v) < 0 ? -(v) : (v)))
+#define YEETMOUSE_FP_ARGS(v) (v) < 0 ? "-" : "", YEETMOUSE_FP_ABS(v) >> 32, \
+    ((YEETMOUSE_FP_ABS(v) & 0xffffffff) * 1000000) >> 32
+
+// Every frame that went through accelerate(). 'speed' is the curve's input (counts/ms, after the offset) and 'gain'
+// its output, before the output cap and the sensitivity. Enable with:
+//     echo 1 > /sys/kernel/tracing/events/yeetmouse/yeetmouse_frame/enable
+TRACE_EVENT(yeetmouse_frame,
+    TP_PROTO(const char *device, int dx, int dy, s64 dt, FP_LONG speed, FP_LONG gain, int out_x, int out_y,
+             FP_LONG carry_x, FP_LONG carry_y),
+
+    TP_ARGS(device, dx, dy, dt, speed, gain, out_x, out_y, carry_x, carry_y),
+
+    TP_STRUCT__entry(
+        __string(device, device)
+        __field(int, dx)
+        __field(int, dy)
+        __field(s64, dt)
+        __field(s64, speed)
+        __field(s64, gain)
+        __field(int, out_x)
+        __field(int, out_y)
+        __field(s64, carry_x)
+        __field(s64, carry_y)
+    ),
+
+    TP_fast_assign(
+        yeetmouse_assign_str(device, device);
+        __entry->dx = dx;
+        __entry->dy = dy;
+        __entry->dt = dt;
+        __entry->speed = speed;
+        __entry->gain = gain;
+        __entry->out_x = out_x;
+        __entry->out_y = out_y;
+        __entry->carry_x = carry_x;
+        __entry->carry_y = carry_y;
+    ),
+
+    TP_printk("device=%s dx=%d dy=%d dt=%lldns speed=" YEETMOUSE_FP_FMT " gain=" YEETMOUSE_FP_FMT
+              " out=%d,%d carry=" YEETMOUSE_FP_FMT "," YEETMOUSE_FP_FMT,
+              __get_str(device), __entry->dx, __entry->dy, __entry->dt,
+              YEETMOUSE_FP_ARGS(__entry->speed), YEETMOUSE_FP_ARGS(__entry->gain), __entry->out_x, __entry->out_y,
+              YEETMOUSE_FP_ARGS(__entry->carry_x), YEETMOUSE_FP_ARGS(__entry->carry_y))
+);
+
+#endif /* _YEETMOUSE_TRACE_H */
+
+// The module is built out of tree, so define_trace.h has to be told where to find this file (-I$(src) in the Makefile)
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE yeetmouse_trace
+#include <trace/define_trace.h>
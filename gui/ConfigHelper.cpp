@@ -67,6 +67,7 @@ namespace ConfigHelper {
             res_ss << "as_threshold=" << params.as_threshold << std::endl;
             res_ss << "as_angle=" << params.as_angle << std::endl;
             res_ss << "LUT_size=" << params.LUT_size << std::endl;
+            res_ss << "LUT_interpolation=" << params.lutInterpolation << std::endl;
             res_ss << "LUT_data=" << DriverHelper::EncodeLutData(params.LUT_data_x, params.LUT_data_y, params.LUT_size);
 
             if(save_to_file) {
@@ -115,6 +116,7 @@ namespace ConfigHelper {
             res_ss << "#define ANGLE_SNAPPING_THRESHOLD " << (params.as_threshold * DEG2RAD) << std::endl;
             res_ss << "#define ANGLE_SNAPPING_ANGLE " << (params.as_angle * DEG2RAD) << std::endl;
             res_ss << "#define LUT_SIZE " << params.LUT_size << std::endl;
+            res_ss << "#define LUT_INTERPOLATION " << params.lutInterpolation << std::endl;
             res_ss << "#define LUT_DATA " << DriverHelper::EncodeLutData(params.LUT_data_x, params.LUT_data_y, params.LUT_size);
 
             if(save_to_file) {
@@ -144,7 +146,7 @@ namespace ConfigHelper {
 #define STRING_2_LOWERCASE(s) std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c){ return std::tolower(c); });
 
     template <typename StreamType>
-    Parameters ImportAny(StreamType& stream, char *lut_data, bool &is_config_h, bool* is_old_config = nullptr) {
+    Parameters ImportAny(StreamType& stream, std::string &lut_data, bool &is_config_h, bool* is_old_config = nullptr) {
         static_assert(std::is_base_of<std::istream, StreamType>::value, "StreamType must be derived from std::istream");
 
         Parameters params;
@@ -243,8 +245,11 @@ namespace ConfigHelper {
                 params.as_angle = val / (is_config_h ? DEG2RAD : 1);
             else if(name == "lut_size")
                 params.LUT_size = val;
+            else if(name == "lut_interpolation")
+                params.lutInterpolation = val == LutInterp_MonotoneCubic || val_str == "LutInterp_MonotoneCubic" ?
+                                          LutInterp_MonotoneCubic : LutInterp_Linear;
             else if(name == "lut_data") {
-                strcpy(lut_data, val_str.c_str());
+                lut_data = val_str;
                 params.LUT_size = DriverHelper::ParseUserLutData(lut_data, params.LUT_data_x, params.LUT_data_y, params.LUT_size);
                 //DriverHelper::ParseDriverLutData(lut_data, params.LUT_data_x, params.LUT_data_y);
             }
@@ -255,7 +260,7 @@ namespace ConfigHelper {
         return params;
     }
 
-    bool ImportFile(char *lut_data, Parameters &params) {
+    bool ImportFile(std::string &lut_data, Parameters &params) {
         const char* filepath = OpenFile();
 
         if(filepath == nullptr)
@@ -302,7 +307,7 @@ namespace ConfigHelper {
         return true;
     }
 
-    bool ImportClipboard(char *lut_data, const char* clipboard, Parameters &params) {
+    bool ImportClipboard(std::string &lut_data, const char* clipboard, Parameters &params) {
         if(clipboard == nullptr)
             return false;
 
@@ -6,8 +6,8 @@
 namespace ConfigHelper {
     std::string ExportPlainText(Parameters params, bool save_to_file);
     std::string ExportConfig(Parameters params, bool save_to_file);
-    bool ImportFile(char *lut_data, Parameters &params);
-    bool ImportClipboard(char *lut_data, const char* clipboard, Parameters &params);
+    bool ImportFile(std::string &lut_data, Parameters &params);
+    bool ImportClipboard(std::string &lut_data, const char* clipboard, Parameters &params);
 } // ConfigHelper
 
 #endif //GUI_CONFIGHELPER_H
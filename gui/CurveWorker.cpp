@@ -0,0 +1,147 @@
+#include "CurveWorker.h"
+
+#include <utility>
+
+CurveWorker::Curve::Curve()
+        : params(std::make_unique<Parameters>()), function(((float) PLOT_X_RANGE) / PLOT_POINTS, params.get()) { }
+
+CurveWorker::Curve &CurveWorker::Curve::operator=(const Curve &other) {
+    if (this != &other) {
+        *params = *other.params;
+        function = other.function;
+        function.params = params.get();
+    }
+    return *this;
+}
+
+CurveWorker::~CurveWorker() {
+    Stop();
+}
+
+void CurveWorker::Start(void (*on_ready)()) {
+    for (int mode = 0; mode < AccelMode_Count; mode++) {
+        curve_requests[mode] = std::make_unique<Parameters>();
+        ready[mode] = std::make_unique<Curve>();
+    }
+    apply_request = std::make_unique<Parameters>();
+
+    this->on_ready = on_ready;
+    stopping = false;
+    thread = std::thread(&CurveWorker::Run, this);
+}
+
+void CurveWorker::Stop() {
+    if (!thread.joinable())
+        return;
+
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void CurveWorker::SubmitCurve(int mode, const Parameters &params, int source_mode) {
+    {
+        std::lock_guard lock(mutex);
+        *curve_requests[mode] = params;
+        curve_source[mode] = source_mode < 0 ? mode : source_mode;
+        has_curve_request[mode] = true;
+    }
+    wake.notify_one();
+}
+
+void CurveWorker::SubmitApply(int mode, const Parameters &params) {
+    {
+        std::lock_guard lock(mutex);
+        *apply_request = params;
+        apply_mode = mode;
+        has_apply_request = true;
+    }
+    wake.notify_one();
+}
+
+bool CurveWorker::TakeCurve(int mode, std::unique_ptr<Curve> &curve) {
+    std::lock_guard lock(mutex);
+    if (!has_ready[mode])
+        return false;
+
+    std::swap(curve, ready[mode]);
+    has_ready[mode] = false;
+    return true;
+}
+
+void CurveWorker::WaitIdle() {
+    std::unique_lock lock(mutex);
+    idle.wait(lock, [this] { return !working && !HasRequests(); });
+}
+
+bool CurveWorker::HasRequests() const {
+    if (has_apply_request)
+        return true;
+    for (bool has_request : has_curve_request)
+        if (has_request)
+            return true;
+    return false;
+}
+
+void CurveWorker::ExportCustomCurve(int mode, Parameters &params) {
+    if (mode == AccelMode_CustomCurve)
+        params.LUT_size = params.customCurve.ExportCurveToLUT(params.LUT_data_x, params.LUT_data_y);
+}
+
+void CurveWorker::Run() {
+    // The worker's side of the handoff, swapped with the requests and the finished curves, so nothing is allocated after the start
+    auto curve = std::make_unique<Curve>();
+    auto apply = std::make_unique<Parameters>();
+
+    std::unique_lock lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || HasRequests(); });
+
+        // Settings are written even when stopping, they were applied by the user
+        if (has_apply_request) {
+            std::swap(apply, apply_request);
+            int mode = apply_mode;
+            has_apply_request = false;
+            working = true;
+            lock.unlock();
+
+            ExportCustomCurve(mode, *apply);
+            apply->SaveAll();
+
+            lock.lock();
+            working = false;
+        }
+        else if (stopping) {
+            break;
+        }
+        else {
+            int mode = next_mode;
+            while (!has_curve_request[mode])
+                mode = (mode + 1) % AccelMode_Count;
+            next_mode = (mode + 1) % AccelMode_Count;
+
+            std::swap(curve->params, curve_requests[mode]);
+            int source = curve_source[mode];
+            has_curve_request[mode] = false;
+            working = true;
+            lock.unlock();
+
+            ExportCustomCurve(source, *curve->params);
+            curve->function.params = curve->params.get();
+            curve->function.PreCacheFunc();
+
+            lock.lock();
+            std::swap(curve, ready[mode]);
+            has_ready[mode] = true;
+            working = false;
+            if (on_ready)
+                on_ready();
+        }
+
+        if (!HasRequests())
+            idle.notify_all();
+    }
+}
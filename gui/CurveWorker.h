@@ -0,0 +1,74 @@
+#ifndef GUI_CURVEWORKER_H
+#define GUI_CURVEWORKER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "FunctionHelper.h"
+
+///
+/// Computes the plotted curves and writes the settings to the driver on a thread of its own, so the render thread never waits for them.
+/// Only the latest request of each mode is kept, older ones are dropped before they start. Finished curves are handed over
+/// by swapping pointers: the UI owns the curve it draws, the worker the one it computes, and the finished one waits in between.
+///
+class CurveWorker {
+public:
+    struct Curve {
+        std::unique_ptr<Parameters> params; // What the curve was computed from, with the Custom Curve's LUT exported
+        CachedFunction function;            // Points to params
+
+        Curve();
+        Curve(const Curve &other) = delete;
+        Curve &operator=(const Curve &other); // Deep copy, function points to the copied params
+    };
+
+    ~CurveWorker();
+
+    // on_ready (if any) is called from the worker every time a curve is finished
+    void Start(void (*on_ready)() = nullptr);
+    // Finishes a pending Apply, pending curves are dropped
+    void Stop();
+
+    // Recomputes the curve of the mode (the GUI's mode index) from a copy of params. source_mode is the mode the params
+    // were copied from, if it isn't mode itself (slot 0 holds the applied mode's, which may be the Custom Curve's)
+    void SubmitCurve(int mode, const Parameters &params, int source_mode = -1);
+    // Writes a copy of params to the driver (Parameters::SaveAll())
+    void SubmitApply(int mode, const Parameters &params);
+
+    // Swaps in the curve of the mode finished since the last call, returns false if there is none
+    bool TakeCurve(int mode, std::unique_ptr<Curve> &curve);
+
+    // Blocks until every submitted request is done
+    void WaitIdle();
+
+private:
+    void Run();
+    bool HasRequests() const;
+
+    // Exports the Custom Curve into the LUT (mode is the GUI's mode index, the Custom Curve is saved as a LUT)
+    static void ExportCustomCurve(int mode, Parameters &params);
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake, idle;
+    void (*on_ready)() = nullptr;
+    bool stopping = false;
+    bool working = false;
+
+    // Requests, a newer one overwrites the one still waiting
+    std::unique_ptr<Parameters> curve_requests[AccelMode_Count];
+    bool has_curve_request[AccelMode_Count] = {};
+    int curve_source[AccelMode_Count] = {};
+    std::unique_ptr<Parameters> apply_request;
+    int apply_mode = 0;
+    bool has_apply_request = false;
+    int next_mode = 0; // Where the search for the next curve request starts, so a mode being dragged doesn't starve the others
+
+    // Finished and not yet taken curves
+    std::unique_ptr<Curve> ready[AccelMode_Count];
+    bool has_ready[AccelMode_Count] = {};
+};
+
+#endif //GUI_CURVEWORKER_H
@@ -7,13 +7,20 @@
 #include <sstream>
 #include <algorithm>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <memory>
 #include <set>
 
 #include "External/ImGui/imgui_internal.h"
 #include "External/ImGui/implot.h"
 
+// The tests point it at a directory of their own
+#ifndef YEETMOUSE_PARAMS_DIR
 #define YEETMOUSE_PARAMS_DIR "/sys/module/yeetmouse/parameters/"
+#endif
 
 template<typename Ty>
 bool GetParameterTy(const std::string& param_name, Ty &value) {
@@ -185,13 +192,8 @@ namespace DriverHelper {
         return true;
     }
 
-    size_t ParseUserLutData(char *szUser_data, double* out_x, double* out_y, size_t out_size) {
-        if(!szUser_data) {
-            strcpy(szUser_data, "Bad data pointer\0");
-            return 0;
-        }
-
-        std::stringstream ss(szUser_data);
+    size_t ParseUserLutData(std::string &user_data, double* out_x, double* out_y, size_t out_size) {
+        std::stringstream ss(user_data);
         size_t idx = 0;
 
         // Skip 2 equal pairs (it would cause kernel to panic...)
@@ -241,13 +243,13 @@ namespace DriverHelper {
 
             // 1 element is not enough for a linear interpolation
             if (idx <= 2 || idx % 2 == 1) {
-                strcpy(szUser_data, "Not enough values or bad formatting\0");
+                user_data = "Not enough values or bad formatting";
                 return 0;
             }
 
             // Make sure all the data was parsed, if not then return 0
             if (!ss.eof()) {
-                sprintf(szUser_data, "Too many samples! (%zu max)", out_size);
+                user_data = "Too many samples! (" + std::to_string(out_size) + " max)";
                 fprintf(stderr, "Too many samples! (%zu max)\n", out_size);
                 return 0;
             }
@@ -313,6 +315,118 @@ namespace DriverHelper {
 
         return res;
     }
+
+    bool WriteLutData(double *data_x, double *data_y, size_t size) {
+        bool res = true;
+        size_t offset = 0;
+
+        while (offset < size && res) {
+            std::string chunk;
+            size_t end = offset;
+            for (; end < size; end++) {
+                std::string point = std::to_string(data_x[end]) + ";" + std::to_string(data_y[end]) + ";";
+                if (chunk.size() + point.size() >= MAX_LUT_BUF_LEN)
+                    break;
+                chunk += point;
+            }
+
+            // Each chunk lands at the index of its first point
+            res &= SetParameterTy("LutDataOffset", offset);
+            res &= SetParameterTy("LutDataBuf", chunk);
+            offset = end;
+        }
+
+        res &= SetParameterTy("LutDataOffset", 0);
+        return res;
+    }
+
+    size_t ReadLutData(double *out_x, double *out_y, size_t size) {
+        size_t points = 0;
+        size = std::min(size, (size_t) MAX_LUT_ARRAY_SIZE);
+
+        // Every read returns as many points from LutDataOffset on as fit into a page
+        while (points < size) {
+            std::string chunk;
+            if (!SetParameterTy("LutDataOffset", points) || !GetParameterS("LutDataBuf", chunk))
+                break;
+
+            std::stringstream ss(chunk);
+            size_t idx = 0;
+            double p = 0;
+            while (points + idx / 2 < size && ss >> p) {
+                (idx % 2 == 0 ? out_x : out_y)[points + idx / 2] = p;
+                idx++;
+                if (ss.peek() == ';')
+                    ss.ignore();
+            }
+
+            if (idx < 2)
+                break;
+            points += idx / 2;
+        }
+
+        SetParameterTy("LutDataOffset", 0);
+        return points;
+    }
+
+    bool ReadConfig(yeetmouse_config &cfg) {
+        int fd = open(YEETMOUSE_CONTROL_DEVICE, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+
+        cfg.size = sizeof(cfg);
+        bool res = ioctl(fd, YEETMOUSE_IOC_GET_CONFIG, &cfg) == 0;
+        close(fd);
+        return res;
+    }
+
+    bool WriteConfig(yeetmouse_config &cfg) {
+        int fd = open(YEETMOUSE_CONTROL_DEVICE, O_RDWR | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+
+        cfg.magic = YEETMOUSE_CONFIG_MAGIC;
+        cfg.version = YEETMOUSE_CONFIG_VERSION;
+        cfg.size = sizeof(cfg);
+        cfg.error = YEETMOUSE_CONFIG_OK;
+
+        bool res = ioctl(fd, YEETMOUSE_IOC_SET_CONFIG, &cfg) == 0;
+        if (!res && cfg.error != YEETMOUSE_CONFIG_OK)
+            fprintf(stderr, "The driver rejected the configuration (%s)\n", ConfigError2String(cfg.error));
+        else if (!res)
+            perror("Error when saving the configuration");
+        close(fd);
+        return res;
+    }
+
+    const char *ConfigError2String(__u32 error) {
+        static_assert(YEETMOUSE_CONFIG_ERROR_COUNT == 10);
+
+        switch (error) {
+            case YEETMOUSE_CONFIG_OK:
+                return "OK";
+            case YEETMOUSE_CONFIG_BAD_HEADER:
+                return "Unknown configuration format";
+            case YEETMOUSE_CONFIG_BAD_VERSION:
+                return "Unsupported configuration version";
+            case YEETMOUSE_CONFIG_BAD_MODE:
+                return "Unknown acceleration mode";
+            case YEETMOUSE_CONFIG_BAD_LUT_SIZE:
+                return "Too many or too few LUT points";
+            case YEETMOUSE_CONFIG_LUT_UNSORTED:
+                return "LUT points are not sorted";
+            case YEETMOUSE_CONFIG_LUT_FLAT_END:
+                return "The last two LUT points have the same x";
+            case YEETMOUSE_CONFIG_BAD_ANGLE_SNAP:
+                return "Angle snapping threshold out of range";
+            case YEETMOUSE_CONFIG_BAD_PARAMETERS:
+                return "Parameters invalid for the acceleration mode";
+            case YEETMOUSE_CONFIG_BAD_INTERPOLATION:
+                return "Unknown LUT interpolation";
+            default:
+                return "Unknown error";
+        }
+    }
 } // DriverHelper
 
 //Parameters::Parameters(float sens, float sensCap, float speedCap, float offset, float accel, float exponent,
@@ -323,6 +437,43 @@ namespace DriverHelper {
 //                                                                           accelMode(accelMode) {}
 
 bool Parameters::SaveAll() {
+    // Drivers with the control device take the whole configuration at once. Whatever the GUI doesn't set (UseCurveTable)
+    // stays as it is.
+    auto cfg = std::make_unique<yeetmouse_config>();
+    if (DriverHelper::ReadConfig(*cfg)) {
+        if (LUT_size == 0 && accelMode == AccelMode_Lut)
+            return false;
+
+        cfg->Sensitivity = FP64_FromDouble(sens);
+        cfg->SensitivityY = FP64_FromDouble(use_anisotropy ? sensY : sens);
+        cfg->OutputCap = FP64_FromDouble(outCap);
+        cfg->InputCap = FP64_FromDouble(inCap);
+        cfg->Offset = FP64_FromDouble(offset);
+        cfg->AccelerationMode = accelMode;
+        cfg->RotationAngle = FP64_FromDouble(rotation * DEG2RAD);
+        cfg->AngleSnap_Threshold = FP64_FromDouble(as_threshold * DEG2RAD);
+        cfg->AngleSnap_Angle = FP64_FromDouble(as_angle * DEG2RAD);
+
+        cfg->Acceleration = FP64_FromDouble(accel);
+        cfg->Exponent = FP64_FromDouble(exponent);
+        cfg->Midpoint = FP64_FromDouble(midpoint);
+        cfg->Motivity = FP64_FromDouble(motivity);
+        cfg->PreScale = FP64_FromDouble(preScale);
+        cfg->UseSmoothing = useSmoothing;
+        cfg->LutInterpolation = lutInterpolation;
+
+        if (LUT_size > 0) {
+            cfg->LutSize = std::min(LUT_size, MAX_LUT_ARRAY_SIZE);
+            for (__u32 i = 0; i < cfg->LutSize; i++) {
+                cfg->LutData_x[i] = FP64_FromDouble(LUT_data_x[i]);
+                cfg->LutData_y[i] = FP64_FromDouble(LUT_data_y[i]);
+            }
+        }
+
+        return DriverHelper::WriteConfig(*cfg);
+    }
+
+    // Older drivers, one parameter at a time and then "update"
     bool res = true;
 
     // General
@@ -343,6 +494,7 @@ bool Parameters::SaveAll() {
     res &= SetParameterTy("Motivity", motivity);
     res &= SetParameterTy("PreScale", preScale);
     res &= SetParameterTy("UseSmoothing", useSmoothing);
+    res &= SetParameterTy("LutInterpolation", (int) lutInterpolation);
 
     // LUT
     auto encodedLutData = DriverHelper::EncodeLutData(LUT_data_x, LUT_data_y, LUT_size);
@@ -350,7 +502,7 @@ bool Parameters::SaveAll() {
         res &= SetParameterTy("LutSize", LUT_size);
         //res &= SetParameterTy("LutStride", LUT_stride);
         //printf("encoded: %s, size: %zu, stride: %i\n", encoded.c_str(), LUT_size, LUT_stride);
-        res &= SetParameterTy("LutDataBuf", encodedLutData);
+        res &= DriverHelper::WriteLutData(LUT_data_x, LUT_data_y, LUT_size);
     }
     else if(accelMode == AccelMode_Lut)
         return false;
@@ -9,7 +9,8 @@
 #include "CustomCurve.h"
 #include "../shared_definitions.h"
 
-#define MAX_LUT_ARRAY_SIZE 128  // THIS NEEDS TO BE THE SAME AS IN THE DRIVER CODE
+#define MAX_LUT_ARRAY_SIZE 4096  // THIS NEEDS TO BE THE SAME AS IN THE DRIVER CODE
+#define MAX_LUT_BUF_LEN 4096 // A single write of LutDataBuf (a sysfs page), bigger LUTs are written in chunks
 
 #define DEG2RAD (M_PI / 180.0)
 
@@ -29,14 +30,28 @@ namespace DriverHelper {
     /// Converts the ugly FP64 representation of user parameters to nice floating point values.\n\n
     bool CleanParameters(int& fixed_num);
 
-    /// Returns the number of parsed values
-    size_t ParseUserLutData(char* user_data, double* out_x, double* out_y, size_t out_size);
+    /// Returns the number of parsed values, on failure user_data is replaced by the reason
+    size_t ParseUserLutData(std::string& user_data, double* out_x, double* out_y, size_t out_size);
 
     /// Returns the number of parsed values
     size_t ParseDriverLutData(const char* user_data, double* out_x, double* out_y);
 
     std::string EncodeLutData(double *data_x, double *data_y, size_t size);
 
+    /// Writes the LUT to the driver in chunks of at most MAX_LUT_BUF_LEN characters
+    bool WriteLutData(double *data_x, double *data_y, size_t size);
+
+    /// Reads up to size points of the LUT back from the driver, returns the number of points read
+    size_t ReadLutData(double *out_x, double *out_y, size_t size);
+
+    /// Reads the whole configuration in use through YEETMOUSE_CONTROL_DEVICE. Fails on drivers without it
+    bool ReadConfig(yeetmouse_config &cfg);
+
+    /// Commits a whole configuration at once, the driver either takes all of it or nothing
+    bool WriteConfig(yeetmouse_config &cfg);
+
+    const char *ConfigError2String(__u32 error);
+
 } // DriverHelper
 
 inline std::string AccelMode2String(AccelMode mode) {
@@ -189,6 +204,7 @@ struct Parameters {
     //float scrollAccel = 1.0f;
     AccelMode accelMode = AccelMode_Current;
     bool useSmoothing = true; // true/false
+    bool useCurveTable = false; // Only read from the driver, so the plots match what it evaluates
     float rotation = 0; // Stored in degrees, converted to radians when writing out
     float as_threshold = 0; // Stored in degrees, converted to radians when writing out
     float as_angle = 0; // Stored in degrees, converted to radians when writing out
@@ -200,6 +216,7 @@ struct Parameters {
     double LUT_data_x[MAX_LUT_ARRAY_SIZE];
     double LUT_data_y[MAX_LUT_ARRAY_SIZE];
     int LUT_size = 0;
+    LutInterpolation lutInterpolation = LutInterp_Linear; // Also used by the Custom Curve, which is saved as a LUT
 
     CustomCurve customCurve{};
 
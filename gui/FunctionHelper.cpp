@@ -1,7 +1,14 @@
 #include <cmath>
+#include <cstring>
 
 #include "FunctionHelper.h"
 
+// The driver's curve code, built for userspace (see the Makefile)
+extern "C" {
+#include "driver/config.h"
+#include "../driver/accel_modes.h"
+}
+
 CachedFunction::CachedFunction(float xStride, Parameters *params)
         : x_stride(xStride), params(params) { }
 
@@ -291,6 +298,14 @@ float CachedFunction::EvalFuncAt(float x) {
 
             //printf("frac: %f\n", frac);
 
+            if (params->lutInterpolation == LutInterp_MonotoneCubic && frac <= 1 && lut_tangents.size() == (size_t) params->LUT_size) {
+                // Cubic Hermite between p and p+1, past the last point it goes on linearly like below
+                double width = params->LUT_data_x[pos + 1] - params->LUT_data_x[pos];
+                double d = (p1 - p) / width, m0 = lut_tangents[pos], m1 = lut_tangents[pos + 1];
+                val = p + width * frac * (m0 + frac * ((3 * d - 2 * m0 - m1) + frac * (m0 + m1 - 2 * d)));
+                break;
+            }
+
             // Interpolate between p and p+1 elements
             val = LERP(p, p1, frac);
             break;
@@ -304,6 +319,33 @@ float CachedFunction::EvalFuncAt(float x) {
     return ((params->outCap > 0) ? fminf(val, params->outCap) : val) * params->sens;
 }
 
+// Fritsch-Carlson, with both tangents of a segment kept within 3x its slope (see lut_build_tangents() in the driver)
+void CachedFunction::LutBuildTangents() {
+    lut_tangents.clear();
+    if (params->lutInterpolation != LutInterp_MonotoneCubic || params->LUT_size < 2)
+        return;
+
+    const int last = params->LUT_size - 1;
+    lut_tangents.resize(params->LUT_size);
+    double d_prev = 0;
+
+    for (int i = 0; i < last; i++) {
+        double width = params->LUT_data_x[i + 1] - params->LUT_data_x[i];
+        double d = width > 0 ? (params->LUT_data_y[i + 1] - params->LUT_data_y[i]) / width : 0;
+
+        if (i == 0)
+            lut_tangents[i] = d;
+        else if (d_prev == 0 || d == 0 || (d_prev < 0) != (d < 0))
+            lut_tangents[i] = 0;
+        else {
+            double limit = 3 * std::min(std::abs(d_prev), std::abs(d));
+            lut_tangents[i] = std::clamp((d_prev + d) / 2, -limit, limit);
+        }
+        d_prev = d;
+    }
+    lut_tangents[last] = d_prev;
+}
+
 void CachedFunction::PreCacheConstants() {
     // Pre-Cache constants
     switch (params->accelMode) {
@@ -348,11 +390,9 @@ void CachedFunction::PreCacheConstants() {
             break;
         }
         case AccelMode_Lut:
-        {
-            break;
-        }
         case AccelMode_CustomCurve:
         {
+            LutBuildTangents();
             break;
         }
         default:
@@ -362,25 +402,72 @@ void CachedFunction::PreCacheConstants() {
     }
 }
 
+// The parameters as the driver would parse them
+static void FillDriverParams(const Parameters &params, accel_params &out) {
+    memset(&out, 0, sizeof(out));
+    out.AccelerationMode = params.accelMode;
+    out.UseSmoothing = params.useSmoothing;
+    out.UseCurveTable = params.useCurveTable;
+    out.LutInterpolation = params.lutInterpolation;
+
+    out.InputCap = FP64_FromDouble(params.inCap);
+    out.Sensitivity = FP64_FromDouble(params.sens);
+    out.SensitivityY = FP64_FromDouble(params.use_anisotropy ? params.sensY : params.sens);
+    out.OutputCap = FP64_FromDouble(params.outCap);
+    out.Offset = FP64_FromDouble(params.offset);
+    out.PreScale = FP64_FromDouble(params.preScale);
+    out.Acceleration = FP64_FromDouble(params.accel);
+    out.Exponent = FP64_FromDouble(params.exponent);
+    out.Midpoint = FP64_FromDouble(params.midpoint);
+    out.Motivity = FP64_FromDouble(params.motivity);
+
+    out.LutSize = std::clamp(params.LUT_size, 0, MAX_LUT_ARRAY_SIZE);
+    for (unsigned long i = 0; i < out.LutSize; i++) {
+        out.LutData_x[i] = FP64_FromDouble(params.LUT_data_x[i]);
+        out.LutData_y[i] = FP64_FromDouble(params.LUT_data_y[i]);
+    }
+
+    update_constants(&out);
+    curve_table_build(&out);
+}
+
 void CachedFunction::PreCacheFunc() {
     PreCacheConstants();
 
-    float x = -params->offset + 0.01;
-    for(int i = 0; i < PLOT_POINTS; i++) {
-        if(x < 0) { // skip offset
-            values[i] = params->sens;
-            values_y[i] = params->sensY;
-            x += x_stride;
-            continue;
-        }
-        float val = EvalFuncAt(x);
-        values[i] = val; // fabsf(params->outCap) > 0.01 ? fminf(val, params->outCap) : val;
+    if (!driver_params)
+        driver_params = std::make_shared<accel_params>();
+    FillDriverParams(*params, *driver_params);
+    const accel_params &dp = *driver_params;
+
+    // The steps of accelerate() around the curve, for every plotted (raw) speed
+    plot_speeds.resize(PLOT_POINTS);
+    plot_gains.resize(PLOT_POINTS);
+    for (int i = 0; i < PLOT_POINTS; i++) {
+        FP_LONG speed = FP64_FromDouble(i * x_stride + 0.01);
+        if (dp.PreScale != FP64_1)
+            speed = FP64_Mul(speed, dp.PreScale);
+        if (dp.InputCap > 0 && speed > dp.InputCap)
+            speed = dp.InputCap;
+        plot_speeds[i] = FP64_Sub(speed, dp.Offset);
+    }
+
+    accel_eval_batch(&dp, plot_speeds.data(), plot_gains.data(), PLOT_POINTS);
+
+    for (int i = 0; i < PLOT_POINTS; i++) {
+        FP_LONG gain = plot_speeds[i] > 0 ? plot_gains[i] : FP64_1;
+        if (dp.OutputCap > 0 && gain > dp.OutputCap)
+            gain = dp.OutputCap;
+
+        values[i] = FP64_ToFloat(FP64_Mul(gain, dp.Sensitivity));
         if (params->use_anisotropy)
-            values_y[i] = val / params->sens * params->sensY;
-        x += x_stride;
+            values_y[i] = FP64_ToFloat(FP64_Mul(gain, dp.SensitivityY));
     }
 
     ValidateSettings();
+
+    // The driver falls back to no acceleration on parameters it can't use
+    if (dp.AccelerationMode != params->accelMode)
+        isValid = false;
 }
 
 
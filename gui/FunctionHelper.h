@@ -2,9 +2,14 @@
 #define GUI_FUNCTIONHELPER_H
 
 
+#include <memory>
+#include <vector>
+
 #include "DriverHelper.h"
 
-#define PLOT_POINTS (512)
+struct accel_params;
+
+#define PLOT_POINTS (4096)
 #define PLOT_X_RANGE (150)
 
 #define LERP(a,b,x)     (((b) - (a)) * (x) + (a))
@@ -21,14 +26,19 @@ public:
     CachedFunction(float xStride, Parameters *params);
     CachedFunction() {};
 
+    // Float version of the curve, independent of the driver's code (the tests check the driver against it)
     float EvalFuncAt(float x);
     void PreCacheConstants();
-    void PreCacheFunc(); // Also validates settings
+    void PreCacheFunc(); // Evaluates the curve with the driver's own code, also validates settings
 
     // Result also saved into 'bool isValid'
     bool ValidateSettings();
 
 private:
+    // The driver's view of params, and the speeds and gains of the plot
+    std::shared_ptr<accel_params> driver_params;
+    std::vector<int64_t> plot_speeds, plot_gains; // FP_LONG
+
     // Constant parameters for Jump
     float smoothness = 0;
     float C0 = 0;
@@ -51,6 +61,11 @@ private:
 
     bool SynchronousBuildLUT();
 
+    // LUT, tangents of the monotone cubic (LutInterp_MonotoneCubic), the same as the driver computes
+    std::vector<double> lut_tangents;
+
+    void LutBuildTangents();
+
     float SynchronousLegacy(float x) const;
     float SynchronousGainEval(float x) const;
 };
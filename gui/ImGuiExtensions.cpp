@@ -23,3 +23,17 @@ bool ImGui::ModeSelectable(const char *label, bool is_selected, ImGuiSelectableF
 bool ImGui::ParameterSlider(const char *label, float &value, float v_speed, float v_min, float v_max) {
     //ImGui::Text()
 }
+
+static int ResizeStringCallback(ImGuiInputTextCallbackData *data) {
+    if (data->EventFlag == ImGuiInputTextFlags_CallbackResize) {
+        auto *str = static_cast<std::string *>(data->UserData);
+        str->resize(data->BufTextLen);
+        data->Buf = str->data();
+    }
+    return 0;
+}
+
+bool ImGui::InputTextMultiline(const char *label, std::string *str, const ImVec2 &size, ImGuiInputTextFlags flags) {
+    return ImGui::InputTextMultiline(label, str->data(), str->capacity() + 1, size, flags | ImGuiInputTextFlags_CallbackResize,
+                                     ResizeStringCallback, str);
+}
@@ -4,10 +4,13 @@
 #define YEETMOUSE_IMGUIEXTENSIONS_H
 
 #include "External/ImGui/imgui.h"
+#include <string>
 
 namespace ImGui {
     bool ModeSelectable(const char* label, bool is_selected = false, ImGuiSelectableFlags flags = 0, const ImVec2 &size = ImVec2(0, 0));
     bool ParameterSlider(const char* label, float& value, float v_speed = 1.0f, float v_min = 0.0f, float v_max = 0.0f);
+    // Edits a std::string, which grows with the text instead of cutting it off at a fixed size
+    bool InputTextMultiline(const char* label, std::string* str, const ImVec2& size = ImVec2(0, 0), ImGuiInputTextFlags flags = 0);
 }
 
 #endif // YEETMOUSE_IMGUIEXTENSIONS_H
\ No newline at end of file
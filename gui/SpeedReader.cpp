@@ -0,0 +1,368 @@
+#include "SpeedReader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#include "FunctionHelper.h"
+
+#define MAX_FRAME_MS 100.0 // Same cap as the driver
+#define EVENT_BATCH 64
+#define STATS_WINDOW_NS 1000000000ull
+#define CURRENT_HOLD_NS 100000000ull // How long the current speed holds without new samples (slow polling rates and hiccups)
+
+#define BIT_SET(bits, n) ((bits)[(n) / (8 * sizeof(long))] & (1ul << ((n) % (8 * sizeof(long)))))
+
+// N of the inputN behind /dev/input/eventM, what the driver's motion records carry
+static uint32_t InputDeviceNumber(const std::string &path) {
+    std::error_code error;
+    std::string event = std::filesystem::path(path).filename();
+    std::string input = std::filesystem::read_symlink("/sys/class/input/" + event + "/device", error).filename();
+
+    unsigned int number;
+    if (error || sscanf(input.c_str(), "input%u", &number) != 1)
+        return MOTION_RECORD_NO_DEVICE;
+    return number;
+}
+
+std::vector<SpeedReader::Device> SpeedReader::DiscoverMice() {
+    std::vector<std::pair<int, Device>> found;
+
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator("/dev/input", error)) {
+        std::string file = entry.path().filename();
+        if (file.rfind("event", 0) != 0)
+            continue;
+
+        int fd = open(entry.path().c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        unsigned long ev_bits[(EV_MAX + 8 * sizeof(long)) / (8 * sizeof(long))] = {};
+        unsigned long rel_bits[(REL_MAX + 8 * sizeof(long)) / (8 * sizeof(long))] = {};
+        unsigned long key_bits[(KEY_MAX + 8 * sizeof(long)) / (8 * sizeof(long))] = {};
+        char name[256] = {};
+
+        // Same checks as driver_match()
+        bool is_mouse = ioctl(fd, EVIOCGBIT(0, sizeof(ev_bits)), ev_bits) >= 0 &&
+                        BIT_SET(ev_bits, EV_REL) && BIT_SET(ev_bits, EV_KEY) &&
+                        ioctl(fd, EVIOCGBIT(EV_REL, sizeof(rel_bits)), rel_bits) >= 0 &&
+                        BIT_SET(rel_bits, REL_X) && BIT_SET(rel_bits, REL_Y) &&
+                        ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(key_bits)), key_bits) >= 0 && BIT_SET(key_bits, BTN_LEFT);
+        if (is_mouse && ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name) < 0)
+            strcpy(name, "Unknown");
+        close(fd);
+
+        if (is_mouse)
+            found.push_back({atoi(file.c_str() + strlen("event")), {entry.path().string(), name}});
+    }
+
+    std::sort(found.begin(), found.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    std::vector<Device> devices;
+    for (auto &[number, device] : found)
+        devices.push_back(std::move(device));
+    return devices;
+}
+
+SpeedReader::~SpeedReader() {
+    Stop();
+}
+
+bool SpeedReader::Start(const std::string &path, void (*on_sample)()) {
+    Stop();
+
+    device_fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (device_fd < 0)
+        return false;
+
+    // Same clock as the driver's motion ring
+    int clock = CLOCK_MONOTONIC;
+    ioctl(device_fd, EVIOCSCLOCKID, &clock);
+
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event device_event = {EPOLLIN, {.fd = device_fd}};
+    epoll_event stop_event = {EPOLLIN, {.fd = stop_fd}};
+    if (stop_fd < 0 || epoll_fd < 0 ||
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, device_fd, &device_event) < 0 ||
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &stop_event) < 0) {
+        Stop();
+        return false;
+    }
+
+    // Without the ring (older drivers), or without knowing which of its records are this mouse's, the events are all there is
+    ring_device = InputDeviceNumber(path);
+    if (ring_device != MOTION_RECORD_NO_DEVICE)
+        ring_fd = open(MOTION_RING_DEVICE, O_RDONLY | O_CLOEXEC);
+    if (ring_fd >= 0) {
+        ring_bytes = sizeof(struct motion_ring) + MOTION_RING_SIZE * sizeof(struct motion_record);
+        void *mapping = mmap(nullptr, ring_bytes, PROT_READ, MAP_SHARED, ring_fd, 0);
+        if (mapping != MAP_FAILED) {
+            ring = static_cast<const struct motion_ring *>(mapping);
+            if (ring->magic != MOTION_RING_MAGIC || ring->version != MOTION_RING_VERSION ||
+                ring->size != MOTION_RING_SIZE || ring->record_size != sizeof(struct motion_record)) {
+                munmap(mapping, ring_bytes);
+                ring = nullptr;
+            }
+        }
+        if (!ring) {
+            close(ring_fd);
+            ring_fd = -1;
+        }
+        else
+            ring_next = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE); // Only what happens from now on
+    }
+
+    frame_dx = frame_dy = 0;
+    frame_motion = false;
+    last_timestamp = 0;
+    last_ms = MAX_FRAME_MS;
+    device_gone = false;
+    samples.Drain([](const Sample &) {});
+
+    this->on_sample = on_sample;
+    raw.store(ring != nullptr, std::memory_order_relaxed);
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&SpeedReader::Run, this);
+    return true;
+}
+
+void SpeedReader::Stop() {
+    if (thread.joinable()) {
+        uint64_t one = 1;
+        if (write(stop_fd, &one, sizeof(one)) < 0) { }
+        thread.join();
+    }
+    running.store(false, std::memory_order_release);
+
+    if (ring)
+        munmap((void *) ring, ring_bytes);
+    ring = nullptr;
+    for (int *fd : {&device_fd, &stop_fd, &epoll_fd, &ring_fd}) {
+        if (*fd >= 0)
+            close(*fd);
+        *fd = -1;
+    }
+}
+
+void SpeedReader::SetParameters(float pre_scale, float input_cap, float offset) {
+    this->pre_scale.store(pre_scale, std::memory_order_relaxed);
+    this->input_cap.store(input_cap, std::memory_order_relaxed);
+    this->offset.store(offset, std::memory_order_relaxed);
+}
+
+void SpeedReader::Run() {
+    epoll_event events[2];
+
+    while (!device_gone) {
+        int count = epoll_wait(epoll_fd, events, 2, -1);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        bool was_empty = samples.Empty();
+        bool stopping = false;
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.fd == stop_fd)
+                stopping = true;
+            else if (events[i].events & (EPOLLERR | EPOLLHUP))
+                device_gone = true;
+            else
+                ReadEvents();
+        }
+        if (stopping)
+            break;
+
+        if (ring)
+            ReadMotionRing();
+
+        if (on_sample && was_empty && !samples.Empty())
+            on_sample();
+    }
+
+    running.store(false, std::memory_order_release);
+}
+
+void SpeedReader::ReadEvents() {
+    input_event buffer[EVENT_BATCH];
+
+    while (true) {
+        ssize_t bytes = read(device_fd, buffer, sizeof(buffer));
+        if (bytes < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN)
+                device_gone = true; // ENODEV once it's unplugged
+            return;
+        }
+
+        // With the ring, the events (already accelerated by the driver) are only the wake-up
+        if (!ring) {
+            for (size_t i = 0; i < bytes / sizeof(input_event); i++) {
+                const input_event &event = buffer[i];
+
+                if (event.type == EV_REL && event.code == REL_X) {
+                    frame_dx += event.value;
+                    frame_motion = true;
+                }
+                else if (event.type == EV_REL && event.code == REL_Y) {
+                    frame_dy += event.value;
+                    frame_motion = true;
+                }
+                else if (event.type == EV_SYN && event.code == SYN_REPORT) {
+                    // Frames without motion (buttons, wheel only) are skipped, like the driver does
+                    if (frame_motion)
+                        PushSample((uint64_t) event.input_event_sec * 1000000000ull + (uint64_t) event.input_event_usec * 1000ull,
+                                   frame_dx, frame_dy);
+                    frame_dx = frame_dy = 0;
+                    frame_motion = false;
+                }
+                else if (event.type == EV_SYN && event.code == SYN_DROPPED) {
+                    frame_dx = frame_dy = 0;
+                    frame_motion = false;
+                }
+            }
+        }
+
+        if ((size_t) bytes < sizeof(buffer))
+            return;
+    }
+}
+
+void SpeedReader::ReadMotionRing() {
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    // Fell behind by more than the whole ring, the oldest ones are gone
+    if (head - ring_next > MOTION_RING_SIZE)
+        ring_next = head - MOTION_RING_SIZE;
+
+    for (; ring_next != head; ring_next++) {
+        const struct motion_record *record = &ring->records[ring_next & (MOTION_RING_SIZE - 1)];
+
+        if (__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) != ring_next + 1)
+            continue;
+        uint32_t device = __atomic_load_n(&record->device, __ATOMIC_RELAXED);
+        uint64_t timestamp = __atomic_load_n(&record->timestamp, __ATOMIC_RELAXED);
+        int64_t speed = __atomic_load_n(&record->speed, __ATOMIC_RELAXED);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (__atomic_load_n(&record->seq, __ATOMIC_RELAXED) != ring_next + 1)
+            continue; // Overwritten while it was copied
+
+        // The ring has the frames of every mouse the driver handles
+        if (device != ring_device)
+            continue;
+
+        // The curve's input, with the Offset already taken off
+        PushSample(timestamp, speed / 4294967296.0 + offset.load(std::memory_order_relaxed));
+    }
+}
+
+// Frame time as in accelerate(): capped at 100 ms, and the last one again if the clock didn't move forward
+double SpeedReader::FrameTime(uint64_t timestamp) {
+    double ms = timestamp > last_timestamp ? std::min((timestamp - last_timestamp) / 1e6, MAX_FRAME_MS) : last_ms;
+    last_timestamp = timestamp;
+    last_ms = ms;
+    return ms;
+}
+
+void SpeedReader::PushSample(uint64_t timestamp, double speed) {
+    double ms = FrameTime(timestamp);
+    samples.Push({timestamp, (float) ms, (float) speed}); // Dropped if the GUI doesn't keep up (paused while unfocused)
+}
+
+void SpeedReader::PushSample(uint64_t timestamp, int dx, int dy) {
+    double ms = FrameTime(timestamp);
+    double speed = std::sqrt((double) dx * dx + (double) dy * dy) * pre_scale.load(std::memory_order_relaxed);
+    float cap = input_cap.load(std::memory_order_relaxed);
+    if (cap > 0 && speed > cap)
+        speed = cap;
+    speed /= ms;
+
+    samples.Push({timestamp, (float) ms, (float) speed}); // Dropped if the GUI doesn't keep up (paused while unfocused)
+}
+
+uint64_t SpeedStats::Now() {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+void SpeedStats::Clear() {
+    *this = SpeedStats();
+}
+
+void SpeedStats::Update(SpeedReader &reader, uint64_t now) {
+    double distance = 0, time = 0;
+    size_t count = reader.Drain([&](const SpeedReader::Sample &sample) {
+        window.push_back(sample);
+        distance += (double) sample.speed * sample.ms;
+        time += sample.ms;
+        last_sample = sample.timestamp;
+    });
+
+    if (count > 0)
+        current = time > 0 ? (float) (distance / time) : 0;
+    else if (now - last_sample > CURRENT_HOLD_NS)
+        current = 0;
+
+    bool expired = false;
+    while (window_start < window.size() && window[window_start].timestamp + STATS_WINDOW_NS < now) {
+        window_start++;
+        expired = true;
+    }
+    if (window_start > window.size() / 2) {
+        window.erase(window.begin(), window.begin() + window_start);
+        window_start = 0;
+    }
+
+    if (count == 0 && !expired)
+        return;
+
+    // Everything else only changes with the window
+    sorted.clear();
+    for (size_t i = window_start; i < window.size(); i++)
+        sorted.push_back(window[i].speed);
+
+    bin_width = (float) PLOT_X_RANGE / SPEED_HISTOGRAM_BINS;
+    std::fill(std::begin(histogram), std::end(histogram), 0.f);
+    rate = (float) sorted.size() * 1e9f / STATS_WINDOW_NS;
+
+    if (sorted.empty()) {
+        top = p50 = p90 = p99 = 0;
+        return;
+    }
+
+    float busiest = 0;
+    for (float speed : sorted) {
+        int bin = (int) (speed / bin_width);
+        if (bin >= 0 && bin < SPEED_HISTOGRAM_BINS)
+            busiest = std::max(busiest, ++histogram[bin]);
+    }
+    if (busiest > 0)
+        for (float &bin : histogram)
+            bin /= busiest;
+
+    auto percentile = [this](float p) {
+        auto nth = sorted.begin() + (size_t) (p * (sorted.size() - 1));
+        std::nth_element(sorted.begin(), nth, sorted.end());
+        return *nth;
+    };
+    p50 = percentile(0.5f);
+    p90 = percentile(0.9f);
+    p99 = percentile(0.99f);
+    top = *std::max_element(sorted.begin(), sorted.end());
+}
@@ -0,0 +1,114 @@
+#ifndef GUI_SPEEDREADER_H
+#define GUI_SPEEDREADER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SpscRing.h"
+#include "../shared_definitions.h"
+
+#define SPEED_HISTOGRAM_BINS 75
+
+///
+/// Samples the input speed of a mouse on a thread of its own, straight from its /dev/input/eventN, at the mouse's polling rate.
+/// The driver changes the events before evdev sees them, so while its motion ring is available the speeds are the driver's own,
+/// from the ring's records of this mouse, and the mouse's events only wake the reader up. Otherwise they're computed from the
+/// events like the driver does it (accelerate() in driver/accel.c).
+///
+class SpeedReader {
+public:
+    struct Device {
+        std::string path; // /dev/input/eventN
+        std::string name;
+    };
+
+    struct Sample {
+        uint64_t timestamp; // ns, CLOCK_MONOTONIC
+        float ms;           // Frame time the speed was computed with
+        float speed;        // counts/ms, before the Offset is subtracted (what the plot's x axis shows)
+    };
+
+    // Every device the driver would handle (relative X and Y axes and a left button), by event number
+    static std::vector<Device> DiscoverMice();
+
+    ~SpeedReader();
+
+    // on_sample (if any) is called from the reader when samples arrive into an empty ring, at most once per drained batch
+    bool Start(const std::string &path, void (*on_sample)() = nullptr);
+    void Stop();
+
+    // False after Stop(), and once the device is gone
+    bool IsRunning() const { return running.load(std::memory_order_acquire); }
+    // Whether the speeds come from the driver's motion ring (otherwise from the events, which are accelerated if the driver handles the mouse)
+    bool IsRaw() const { return raw.load(std::memory_order_relaxed); }
+
+    // The driver's Pre-Scale and Input Cap (for the speeds computed from the events) and Offset (added back to the driver's
+    // speeds), applied to the following samples
+    void SetParameters(float pre_scale, float input_cap, float offset);
+
+    // Calls f for every sample since the last call, oldest first. UI thread only
+    template<typename F>
+    size_t Drain(F &&f) { return samples.Drain(f); }
+
+private:
+    void Run();
+    void ReadEvents();
+    void ReadMotionRing();
+    double FrameTime(uint64_t timestamp);
+    void PushSample(uint64_t timestamp, int dx, int dy);
+    void PushSample(uint64_t timestamp, double speed);
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> raw{false};
+    std::atomic<float> pre_scale{1}, input_cap{0}, offset{0};
+    void (*on_sample)() = nullptr;
+
+    int device_fd = -1, stop_fd = -1, epoll_fd = -1;
+
+    // Driver's motion ring, if it could be mapped
+    const struct motion_ring *ring = nullptr;
+    size_t ring_bytes = 0;
+    int ring_fd = -1;
+    uint64_t ring_next = 0;
+    uint32_t ring_device = MOTION_RECORD_NO_DEVICE; // Records of other mice are skipped
+
+    // Frame being assembled from the events and the speed state, reader thread only
+    int frame_dx = 0, frame_dy = 0;
+    bool frame_motion = false;
+    uint64_t last_timestamp = 0;
+    double last_ms = 100;
+    bool device_gone = false;
+
+    SpscRing<Sample, 16384> samples; // Two seconds at 8 kHz
+};
+
+///
+/// What the GUI shows of the samples: the current speed, the top speed and the distribution over the last second. UI thread only.
+///
+class SpeedStats {
+public:
+    // Drains the reader, now in ns (CLOCK_MONOTONIC)
+    void Update(SpeedReader &reader, uint64_t now);
+    void Clear();
+
+    static uint64_t Now();
+
+    float current = 0;  // Mean speed since the last update (distance over time), kept for a moment when no samples arrive
+    float top = 0;      // Over the window
+    float p50 = 0, p90 = 0, p99 = 0;
+    float rate = 0;     // Samples per second
+    float histogram[SPEED_HISTOGRAM_BINS] = {}; // Over [0, PLOT_X_RANGE), share of the busiest bin (0 - 1)
+    float bin_width = 0;
+
+private:
+    std::vector<SpeedReader::Sample> window; // Last second, oldest first
+    size_t window_start = 0;
+    std::vector<float> sorted;
+    uint64_t last_sample = 0;
+};
+
+#endif //GUI_SPEEDREADER_H
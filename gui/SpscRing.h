@@ -0,0 +1,50 @@
+#ifndef GUI_SPSCRING_H
+#define GUI_SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+
+///
+/// Lock-free ring for exactly one producer and one consumer thread. N has to be a power of two.
+///
+template<typename T, size_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "The size of the ring has to be a power of two");
+
+public:
+    // Producer only. Returns false (and drops the item) when the ring is full
+    bool Push(const T &item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == N)
+            return false;
+
+        items[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Calls f for every item in the ring, oldest first, and returns their number
+    template<typename F>
+    size_t Drain(F &&f) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+
+        for (size_t i = t; i != h; i++)
+            f(items[i & (N - 1)]);
+
+        tail.store(h, std::memory_order_release);
+        return h - t;
+    }
+
+    // Either side, only a hint while the other one is running
+    bool Empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head{0}; // Written by the producer
+    alignas(64) std::atomic<size_t> tail{0}; // Written by the consumer
+    alignas(64) T items[N];
+};
+
+#endif //GUI_SPSCRING_H
@@ -0,0 +1,25 @@
+#pragma once
+
+#ifndef CONFIG
+#define CONFIG
+
+// Userspace stand-in for the driver's config.h, so the GUI can build the driver's curve code (driver/accel_modes.c)
+// like the tests do (see tests/driver/config.h)
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <limits.h>
+#include <stdbool.h>
+#define printk printf
+
+#include "../../driver/FixedMath/Fixed64.h"
+static float FP64_ToFloat(FP_LONG v) {
+    return (float) v * (1.0f / 4294967296.0f);
+}
+
+#ifndef MIN
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#endif
+
+#endif
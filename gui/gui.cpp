@@ -1,6 +1,9 @@
 #include "gui.h"
 #include "fonts.h"
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include "External/ImGui/imgui_internal.h"
 #define GL_SILENCE_DEPRECATION
 #if defined(IMGUI_IMPL_OPENGL_ES2)
 #include <GLES2/gl2.h>
@@ -19,6 +22,10 @@
 int (*MainOnGui)();
 int RenderFrame();
 
+// How long the frames keep coming at the display rate after input (hover highlights, tooltips and such)
+#define ACTIVE_TIME std::chrono::milliseconds(500)
+static std::chrono::steady_clock::time_point active_until;
+
 static void glfw_error_callback(int error, const char* description)
 {
     fprintf(stderr, "GLFW Error %d: %s\n", error, description);
@@ -216,6 +223,63 @@ void GUI::ShutDown() {
     glfwTerminate();
 }
 
+void GUI::RequestFrames() {
+    active_until = std::chrono::steady_clock::now() + ACTIVE_TIME;
+}
+
+// Set by Wake(), lets a single frame through while the window is paused for being unfocused
+static std::atomic<bool> woken{false};
+
+void GUI::Wake() {
+    woken.store(true, std::memory_order_release);
+    glfwPostEmptyEvent();
+}
+
+static bool IsMinimized() {
+    return glfwGetWindowAttrib(GUI::window, GLFW_ICONIFIED);
+}
+
+static bool IsPaused() {
+    if (IsMinimized())
+        return true;
+    return GUI::render_settings.pause_unfocused && !glfwGetWindowAttrib(GUI::window, GLFW_FOCUSED);
+}
+
+// Handles the events, waiting for them while nothing happens. Returns false if there is nothing to draw
+static bool WaitForFrame() {
+    const GUI::RenderSettings &settings = GUI::render_settings;
+
+    if (IsPaused()) {
+        // Something changed in the background (a finished curve, the speed indicator), it's drawn even though nobody's
+        // looking, along with the frames it asks for to settle (RequestFrames())
+        bool settling = !IsMinimized() && std::chrono::steady_clock::now() < active_until;
+        if (settling)
+            glfwPollEvents();
+        else
+            glfwWaitEvents();
+
+        if (IsPaused()) {
+            bool woke = woken.exchange(false, std::memory_order_acquire);
+            return !IsMinimized() && (woke || settling);
+        }
+        GUI::RequestFrames();
+        return true;
+    }
+    woken.store(false, std::memory_order_relaxed); // Drawing anyway
+
+    if (!settings.event_driven || std::chrono::steady_clock::now() < active_until)
+        glfwPollEvents();
+    else if (settings.idle_fps > 0)
+        glfwWaitEventsTimeout(1.0 / settings.idle_fps);
+    else
+        glfwWaitEvents();
+
+    // Any input for ImGui (mouse, keyboard, focus) keeps the frames coming for a while
+    if (!GImGui->InputEventsQueue.empty())
+        GUI::RequestFrames();
+    return true;
+}
+
 int GUI::RenderFrame() {
     if(glfwWindowShouldClose(window))
         return 1;
@@ -225,7 +289,8 @@ int GUI::RenderFrame() {
     // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application, or clear/overwrite your copy of the mouse data.
     // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application, or clear/overwrite your copy of the keyboard data.
     // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-    glfwPollEvents();
+    if (!WaitForFrame())
+        return 0;
 
     // Start the Dear ImGui frame
     ImGui_ImplOpenGL3_NewFrame();
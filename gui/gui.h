@@ -13,5 +13,17 @@ namespace GUI
 
     inline GLFWwindow* window;
 
+    struct RenderSettings {
+        bool event_driven = true;       // Only redraw after input (and a moment after it) or when requested, instead of every vsync
+        int idle_fps = 10;              // Frame cap while nothing happens (event driven only), 0 draws on events alone
+        bool pause_unfocused = true;    // Only the frames asked for by Wake() while the window is unfocused. Nothing is drawn while it's minimized either way
+    };
+    inline RenderSettings render_settings;
+
+    // Keeps drawing at the display rate for a moment, for anything that is still moving on screen
+    void RequestFrames();
+    // Wakes the render thread for a frame (even while paused for being unfocused), can be called from any thread
+    void Wake();
+
     void GetMousePos(double *x, double *y);
 }
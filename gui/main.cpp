@@ -6,7 +6,10 @@
 #include "FunctionHelper.h"
 #include "ImGuiExtensions.h"
 #include "ConfigHelper.h"
+#include "CurveWorker.h"
+#include "SpeedReader.h"
 #include <chrono>
+#include <cstring>
 #include <vector>
 #include <unistd.h>
 
@@ -30,18 +33,54 @@ static_assert(sizeof(AccelModes) / sizeof(char*) == AccelMode_Count);
 #define NUM_MODES AccelMode_Count //(sizeof(AccelModes) / sizeof(char *))
 
 Parameters params[NUM_MODES]; // Driver parameters for each mode
-CachedFunction functions[NUM_MODES]; // Driver parameters for each mode
+std::unique_ptr<CurveWorker::Curve> curves[NUM_MODES]; // Latest finished curve of each mode
+CurveWorker curve_worker;
+SpeedReader speed_reader; // Samples the selected mouse for the speed indicator
+SpeedStats speed_stats;
+std::vector<SpeedReader::Device> devices;
+int selected_device = -1; // -1 estimates the speed from the cursor instead
+std::string device_error;
 AccelMode used_mode = AccelMode_Linear;
 bool was_initialized = false;
 bool has_privilege = false;
 
-static char LUT_user_data[4096];
+static std::string LUT_user_data; // Grows with the LUT, a full one is far more than a few KB of text
 
 void ResetParameters();
 
-#define RefreshDevices() {devices = DriverHelper::DiscoverDevices(); \
-                            if(selected_device >= devices.size())    \
-                            selected_device = devices.size() - 1;}
+// Shared by the LUT and the Custom Curve
+static bool LutInterpolationCheckbox(LutInterpolation &interpolation) {
+    bool cubic = interpolation == LutInterp_MonotoneCubic;
+    bool change = ImGui::Checkbox("Smooth Interpolation", &cubic);
+    ImGui::SetItemTooltip("Monotone cubic between the points instead of straight lines, so far fewer points are needed for a smooth curve");
+    if (change)
+        interpolation = cubic ? LutInterp_MonotoneCubic : LutInterp_Linear;
+    return change;
+}
+
+// Keeps the selected mouse selected if it's still there
+static void RefreshDevices() {
+    std::string selected = selected_device >= 0 ? devices[selected_device].path : "";
+    devices = SpeedReader::DiscoverMice();
+    selected_device = -1;
+    for (int i = 0; i < (int) devices.size(); i++)
+        if (devices[i].path == selected)
+            selected_device = i;
+}
+
+static void SelectDevice(int device) {
+    speed_reader.Stop();
+    speed_stats.Clear();
+    selected_device = -1;
+    device_error.clear();
+
+    if (device < 0)
+        return;
+    if (speed_reader.Start(devices[device].path, GUI::Wake)) // The indicator moves with the mouse, even while idle
+        selected_device = device;
+    else
+        device_error = "Can't open " + devices[device].path + ": " + strerror(errno);
+}
 
 int OnGui() {
     using namespace std::chrono;
@@ -49,12 +88,22 @@ int OnGui() {
     ImGuiContext& g = *GImGui;
 
     static float mouse_smooth = 0.75;
-    static steady_clock::time_point last_apply_clicked;
     static bool show_custom_curve_control_points = true, move_control_points_along = false, show_custom_curve_LUT_points = false;
 
+    // Pick up the curves the worker finished since the last frame
+    for (int mode = 0; mode < NUM_MODES; mode++) {
+        if (curve_worker.TakeCurve(mode, curves[mode]) && mode == AccelMode_CustomCurve) {
+            // The LUT the curve was exported into, for "Show LUT Points" and the export
+            const Parameters &exported = *curves[mode]->params;
+            params[mode].LUT_size = exported.LUT_size;
+            memcpy(params[mode].LUT_data_x, exported.LUT_data_x, exported.LUT_size * sizeof(exported.LUT_data_x[0]));
+            memcpy(params[mode].LUT_data_y, exported.LUT_data_y, exported.LUT_size * sizeof(exported.LUT_data_y[0]));
+        }
+    }
+
     if (ImGui::BeginMainMenuBar()) {
         if (ImGui::BeginMenu("File")) {
-            ImGui::BeginDisabled(!functions[selected_mode].isValid);
+            ImGui::BeginDisabled(!curves[selected_mode]->function.isValid);
             if (ImGui::BeginMenu("Export")) {
                 if (ImGui::MenuItem("Plain text")) {
                     //printf("Plain text:\n%s\n", ConfigHelper::ExportPlainText(params[selected_mode], true).c_str());
@@ -81,7 +130,7 @@ int OnGui() {
             }
             ImGui::EndDisabled();
 
-            if (!functions[selected_mode].isValid)
+            if (!curves[selected_mode]->function.isValid)
                 ImGui::SetItemTooltip("Can't export invalid parameters");
 
             Parameters imported_params;
@@ -101,6 +150,7 @@ int OnGui() {
             }
 
             if (changed) {
+                imported_params.useCurveTable = params[selected_mode].useCurveTable; // Not part of the configs
                 for (int i = 1; i < NUM_MODES; i++) {
                     if (i == AccelMode_CustomCurve) { // Preserve the custom curve points when copying
                         CustomCurve curve = params[AccelMode_CustomCurve].customCurve;
@@ -108,7 +158,6 @@ int OnGui() {
                         params[i].customCurve = curve;
                         params[i].accelMode = AccelMode_Lut;
 
-                        params[i].LUT_size = params[i].customCurve.ExportCurveToLUT(params[i].LUT_data_x, params[i].LUT_data_y);
                         params[i].customCurve.UpdateLUT();
                     }
                     else {
@@ -116,14 +165,25 @@ int OnGui() {
                         params[i].accelMode = static_cast<AccelMode>(i == 0 ? used_mode : i);
                     }
 
-                    functions[i] = CachedFunction(((float) PLOT_X_RANGE) / PLOT_POINTS, &params[i]);
-                    functions[i].PreCacheFunc();
+                    curve_worker.SubmitCurve(i, params[i]);
                 }
 
                 selected_mode = imported_params.accelMode;
             }
             ImGui::EndMenu();
         }
+        if (ImGui::BeginMenu("View")) {
+            GUI::RenderSettings &render = GUI::render_settings;
+            ImGui::MenuItem("Power Saving", nullptr, &render.event_driven);
+            ImGui::SetItemTooltip("Redraws only after input or when something changes, instead of at the display's refresh rate");
+            ImGui::BeginDisabled(!render.event_driven);
+            ImGui::SliderInt("##IdleFps", &render.idle_fps, 0, 60, render.idle_fps ? "Idle Frame Rate %d" : "No Idle Frames");
+            ImGui::SetItemTooltip("Frame rate while nothing happens");
+            ImGui::EndDisabled();
+            ImGui::MenuItem("Pause When Unfocused", nullptr, &render.pause_unfocused);
+            ImGui::SetItemTooltip("While another window has the focus, draws only what changes on its own (a finished curve, a sampled mouse)");
+            ImGui::EndMenu();
+        }
         ImGui::EndMainMenuBar();
     }
 
@@ -336,9 +396,10 @@ int OnGui() {
             }
             case AccelMode_Lut: {
                 ImGui::Text("LUT data:");
-                change |= ImGui::InputTextWithHint("##LUT data", "x1,y1;x2,y2;x3,y3...", LUT_user_data,
-                                                   sizeof(LUT_user_data), ImGuiInputTextFlags_AutoSelectAll);
+                change |= ImGui::InputTextMultiline("##LUT data", &LUT_user_data,
+                                                    {-1, ImGui::GetTextLineHeight() * 6}, ImGuiInputTextFlags_AutoSelectAll);
                 ImGui::SetItemTooltip("Format: x1,y1;x2,y2;x3,y3... (commas and semicolons are treated equally)");
+                change |= LutInterpolationCheckbox(params[selected_mode].lutInterpolation);
                 //change |= ImGui::DragFloat("##LUT_Stride_Param", &params[selected_mode].LUT_stride, 0.05, 0.05, 10, "Stride %0.2f");
                 //ImGui::SetItemTooltip("Gap between each 'y' value");
                 if (ImGui::Button("Save", {-1, 0})) {
@@ -363,6 +424,8 @@ int OnGui() {
                 ImGui::Checkbox("Link Control Points", &move_control_points_along);
                 ImGui::SetItemTooltip("Moves control points along with it's parent curve point");
 
+                change |= LutInterpolationCheckbox(params[selected_mode].lutInterpolation);
+
                 auto& points = params[selected_mode].customCurve.points;
                 auto& control_points = params[selected_mode].customCurve.control_points;
 
@@ -436,7 +499,6 @@ int OnGui() {
 
                 if (change) {
                     params[selected_mode].customCurve.ApplyCurveConstraints();
-                    params[selected_mode].LUT_size = params[selected_mode].customCurve.ExportCurveToLUT(params[selected_mode].LUT_data_x, params[selected_mode].LUT_data_y);
                     params[selected_mode].customCurve.UpdateLUT();
                 }
 
@@ -460,7 +522,7 @@ int OnGui() {
             ImGui::SetItemTooltip("Rotation is applied after Angle Snapping");
 
         if (change)
-            functions[selected_mode].PreCacheFunc();
+            curve_worker.SubmitCurve(selected_mode, params[selected_mode]);
 
         ImGui::PopItemWidth();
     } else
@@ -481,7 +543,32 @@ int OnGui() {
                           ImGuiChildFlags_FrameStyle)) {
         auto avail = ImGui::GetContentRegionAvail();
         ImGui::PopStyleColor();
-        ImGui::PushItemWidth(avail.x);
+
+        ImGui::PushItemWidth(avail.x * 0.35f);
+        if (ImGui::BeginCombo("##SpeedSource", selected_device >= 0 ? devices[selected_device].name.c_str() : "Cursor")) {
+            if (ImGui::IsWindowAppearing())
+                RefreshDevices();
+            if (ImGui::Selectable("Cursor", selected_device < 0))
+                SelectDevice(-1);
+            for (int i = 0; i < (int) devices.size(); i++) {
+                ImGui::PushID(i);
+                std::string label = devices[i].name + " (" + devices[i].path + ")";
+                if (ImGui::Selectable(label.c_str(), i == selected_device))
+                    SelectDevice(i);
+                ImGui::PopID();
+            }
+            ImGui::EndCombo();
+        }
+        if (!device_error.empty())
+            ImGui::SetItemTooltip("%s", device_error.c_str());
+        else if (selected_device >= 0 && !speed_reader.IsRaw())
+            ImGui::SetItemTooltip("The driver's motion ring isn't available, the speeds of mice it accelerates are the accelerated ones");
+        else
+            ImGui::SetItemTooltip("Where the speed indicator comes from: the cursor, once per frame, or every report of a mouse");
+        ImGui::PopItemWidth();
+
+        ImGui::SameLine();
+        ImGui::PushItemWidth(-1);
 #ifdef USE_INPUT_DRAG
                 ImGui::DragFloat("##MouseSmoothness", &mouse_smooth, 0.001, 0.0, 0.99, "Mouse Smoothness %0.2f");
 #else
@@ -504,13 +591,26 @@ int OnGui() {
     static ImVec2 last_mouse_pos = {0, 0};
     double mouse_pos[2];
     GUI::GetMousePos(mouse_pos, mouse_pos + 1);
-    ImVec2 mouse_delta = {
-        static_cast<float>(mouse_pos[0] - last_mouse_pos.x), static_cast<float>(mouse_pos[1] - last_mouse_pos.y)
-    };
-    float mouse_speed = std::sqrt(ImLengthSqr(mouse_delta));
-    mouse_speed = mouse_speed / std::chrono::duration_cast<milliseconds>(steady_clock::now() - last_probe_time).count();
-    mouse_speed /= functions[0].EvalFuncAt(mouse_speed); // Normalize in regard to acceleration (to get raw speed)
-    // It's a rough approximation because in the time of 1 frame, tens of mouse packets can be received (thus "accelerated").
+    float mouse_speed;
+    if (selected_device >= 0 && !speed_reader.IsRunning()) {
+        SelectDevice(-1);
+        device_error = "The mouse was disconnected";
+    }
+    if (selected_device >= 0) {
+        // Every report of the mouse since the last frame, already raw
+        speed_reader.SetParameters(params[0].preScale, params[0].inCap, params[0].offset);
+        speed_stats.Update(speed_reader, SpeedStats::Now());
+        mouse_speed = speed_stats.current;
+    }
+    else {
+        ImVec2 mouse_delta = {
+            static_cast<float>(mouse_pos[0] - last_mouse_pos.x), static_cast<float>(mouse_pos[1] - last_mouse_pos.y)
+        };
+        mouse_speed = std::sqrt(ImLengthSqr(mouse_delta));
+        mouse_speed = mouse_speed / std::chrono::duration_cast<milliseconds>(steady_clock::now() - last_probe_time).count();
+        mouse_speed /= curves[0]->function.EvalFuncAt(mouse_speed); // Normalize in regard to acceleration (to get raw speed)
+        // It's a rough approximation because in the time of 1 frame, tens of mouse packets can be received (thus "accelerated").
+    }
     last_probe_time = steady_clock::now();
     if (mouse_speed > recent_mouse_top_speed) {
         recent_mouse_top_speed = mouse_speed;
@@ -519,22 +619,27 @@ int OnGui() {
     float avg_speed = fmaxf(mouse_speed * (1 - mouse_smooth) + last_frame_speed * mouse_smooth, 0.01);
     ImPlotPoint mousePoint_main = ImPlotPoint(avg_speed, avg_speed < params[selected_mode].offset
                                                              ? params[selected_mode].sens
-                                                             : functions[selected_mode].EvalFuncAt(
+                                                             : curves[selected_mode]->function.EvalFuncAt(
                                                                  avg_speed - params[selected_mode].offset));
 
     last_mouse_pos = {(float) mouse_pos[0], (float) mouse_pos[1]};
 
+    // The indicator eases out and the top speed dot stays for a second, keep drawing until both are done
+    if (std::abs(avg_speed - last_frame_speed) > 0.01f || recent_mouse_top_speed > 0)
+        GUI::RequestFrames();
 
     last_frame_speed = avg_speed;
 
     // Check if a second passed since the last highest mouse speed, if so reset the record speed dot
     if (duration_cast<milliseconds>(steady_clock::now() - last_time_speed_record_broken).count() > 1000)
         recent_mouse_top_speed = 0;
+    if (selected_device >= 0)
+        recent_mouse_top_speed = speed_stats.top; // Of every report in the last second, not only of the frames
 
     ImPlotPoint mousePoint_topSpeed = ImPlotPoint(recent_mouse_top_speed,
                                                   recent_mouse_top_speed < params[selected_mode].offset
                                                       ? params[selected_mode].sens
-                                                      : functions[selected_mode].EvalFuncAt(
+                                                      : curves[selected_mode]->function.EvalFuncAt(
                                                           recent_mouse_top_speed - params[selected_mode].offset));
 
     ImPlot::SetNextAxesLimits(0, PLOT_X_RANGE, 0, 4);
@@ -546,13 +651,26 @@ int OnGui() {
         // Display currently applied parameters in the background
         if (was_initialized) {
             ImPlot::SetNextLineStyle(ImVec4(0.3, 0.3, 0.3, 1));
-            ImPlot::PlotLine("Function in use", functions[0].values, PLOT_POINTS, functions[0].x_stride);
+            ImPlot::PlotLine("Function in use", curves[0]->function.values, PLOT_POINTS, curves[0]->function.x_stride);
+        }
+
+        // Where the mouse's speeds fell in the last second, the busiest bin reaching 1
+        if (selected_device >= 0) {
+            char label[128];
+            snprintf(label, sizeof(label), "Input Speeds (p50 %.1f, p90 %.1f, p99 %.1f, %.0f Hz)###InputSpeeds",
+                     speed_stats.p50, speed_stats.p90, speed_stats.p99, speed_stats.rate);
+            ImPlot::SetNextFillStyle(ImVec4(0.8, 0.6, 0.2, 1), 0.3f);
+            ImPlot::SetNextLineStyle(ImVec4(0, 0, 0, 0));
+            ImPlot::PlotBarsG(label, [](int idx, void *data) {
+                auto *stats = (SpeedStats *) data;
+                return ImPlotPoint((idx + 0.5) * stats->bin_width, stats->histogram[idx]);
+            }, &speed_stats, SPEED_HISTOGRAM_BINS, speed_stats.bin_width);
         }
 
         if (params[selected_mode].use_anisotropy) {
             ImPlot::SetNextLineStyle(ImVec4(0.3, 0.3, 0.8, 1), 2);
-            ImPlot::PlotLine("Active Mode Y##ActivePlotY", functions[selected_mode].values_y, PLOT_POINTS,
-                             functions[selected_mode].x_stride);
+            ImPlot::PlotLine("Active Mode Y##ActivePlotY", curves[selected_mode]->function.values_y, PLOT_POINTS,
+                             curves[selected_mode]->function.x_stride);
         }
 
         ImPlot::SetNextLineStyle(ImColor(0.3f, 0.5f, 0.7f, 1.0f), 2);
@@ -805,9 +923,8 @@ int OnGui() {
 
             if (modified) {
                 params[selected_mode].customCurve.ApplyCurveConstraints();
-                params[selected_mode].LUT_size = params[selected_mode].customCurve.ExportCurveToLUT(params[selected_mode].LUT_data_x, params[selected_mode].LUT_data_y);
                 params[selected_mode].customCurve.UpdateLUT();
-                functions[selected_mode].PreCacheFunc();
+                curve_worker.SubmitCurve(selected_mode, params[selected_mode]);
             }
 
             // Draw the curve
@@ -824,19 +941,19 @@ int OnGui() {
                         return ImPlotPoint(x, y);
                     }, &params[selected_mode], params[selected_mode].LUT_size);
 
-                    ImPlot::PlotLine("##ActivePlot", functions[selected_mode].values, PLOT_POINTS,
-                        functions[selected_mode].x_stride);
+                    ImPlot::PlotLine("##ActivePlot", curves[selected_mode]->function.values, PLOT_POINTS,
+                        curves[selected_mode]->function.x_stride);
                 }
             }
 
-            // ImPlot::PlotLine("##ActivePlot", functions[selected_mode].values, PLOT_POINTS,
-            //              functions[selected_mode].x_stride);
+            // ImPlot::PlotLine("##ActivePlot", curves[selected_mode]->function.values, PLOT_POINTS,
+            //              curves[selected_mode]->function.x_stride);
 
             last_held_point = held_point;
         }
         else
-            ImPlot::PlotLine("##ActivePlot", functions[selected_mode].values, PLOT_POINTS,
-                         functions[selected_mode].x_stride);
+            ImPlot::PlotLine("##ActivePlot", curves[selected_mode]->function.values, PLOT_POINTS,
+                         curves[selected_mode]->function.x_stride);
 
         ImPlot::PlotScatterG("Mouse Speed", [](int idx, void *data) { return *(ImPlotPoint *) data; }, &mousePoint_main,
                              1);
@@ -850,8 +967,8 @@ int OnGui() {
 
         if (hovered_mode != -1 && selected_mode != hovered_mode) {
             ImPlot::SetNextLineStyle(ImVec4(0.7, 0.7, 0.3, 1));
-            ImPlot::PlotLine("##Hovered Function", functions[hovered_mode].values, PLOT_POINTS,
-                             functions[hovered_mode].x_stride);
+            ImPlot::PlotLine("##Hovered Function", curves[hovered_mode]->function.values, PLOT_POINTS,
+                             curves[hovered_mode]->function.x_stride);
         }
 
         ImPlot::EndPlot();
@@ -876,23 +993,21 @@ int OnGui() {
 
         ImGui::SameLine();
 
-        // Disable Apply button for 1.1 second after clicking it (this is a driver "limitation")
         ImGui::BeginDisabled(!has_privilege || !was_initialized ||
-                             duration_cast<milliseconds>(steady_clock::now() - last_apply_clicked).count() < 1100 ||
                              (selected_mode == AccelMode_Lut /* LUT */ && params[selected_mode].LUT_size == 0) ||
-                             !functions[selected_mode].isValid);
+                             !curves[selected_mode]->function.isValid);
 
         if (ImGui::Button("Apply", {-1, -1})) {
-            params[selected_mode].SaveAll();
-            functions[0] = functions[selected_mode];
+            curve_worker.SubmitApply(selected_mode, params[selected_mode]);
             params[0] = params[selected_mode];
+            // Not a copy of curves[selected_mode], an edit of it may still be in flight
+            curve_worker.SubmitCurve(0, params[0], selected_mode);
             used_mode = selected_mode;
-            last_apply_clicked = steady_clock::now();
         }
 
         ImGui::EndDisabled();
 
-        if (!functions[selected_mode].isValid) {
+        if (!curves[selected_mode]->function.isValid) {
             ImGui::SetItemTooltip("Invalid parameters");
         }
 
@@ -951,16 +1066,14 @@ void ResetParameters(void) {
 
         if (mode == AccelMode_CustomCurve) {
             params->customCurve.ApplyCurveConstraints();
-            params[mode].LUT_size = params[mode].customCurve.ExportCurveToLUT(params[mode].LUT_data_x, params[mode].LUT_data_y);
             params[mode].customCurve.UpdateLUT();
         }
 
-        functions[mode] = CachedFunction(((float) PLOT_X_RANGE) / PLOT_POINTS, &params[mode]);
-        //printf("stride = %f\n", functions[mode].x_stride);
-        bool old_use_ani = functions[mode].params->use_anisotropy;
-        functions[mode].params->use_anisotropy = true;
-        functions[mode].PreCacheFunc();
-        functions[mode].params->use_anisotropy = old_use_ani;
+        // With the Y curve as well, so it's there as soon as anisotropy is turned on
+        bool old_use_ani = params[mode].use_anisotropy;
+        params[mode].use_anisotropy = true;
+        curve_worker.SubmitCurve(mode, params[mode]);
+        params[mode].use_anisotropy = old_use_ani;
     }
 }
 
@@ -1001,7 +1114,11 @@ int main() {
         DriverHelper::GetParameterF("PreScale", start_params.preScale);
         DriverHelper::GetParameterI("AccelerationMode", reinterpret_cast<int &>(start_params.accelMode));
         DriverHelper::GetParameterB("UseSmoothing", start_params.useSmoothing);
+        DriverHelper::GetParameterB("UseCurveTable", start_params.useCurveTable);
         DriverHelper::GetParameterI("LutSize", start_params.LUT_size);
+        int lut_interpolation = 0;
+        if (DriverHelper::GetParameterI("LutInterpolation", lut_interpolation))
+            start_params.lutInterpolation = static_cast<LutInterpolation>(std::clamp(lut_interpolation, 0, LutInterp_Count - 1));
         DriverHelper::GetParameterF("RotationAngle", start_params.rotation);
         start_params.rotation /= DEG2RAD;
         DriverHelper::GetParameterF("AngleSnap_Threshold", start_params.as_threshold);
@@ -1009,10 +1126,8 @@ int main() {
         DriverHelper::GetParameterF("AngleSnap_Angle", start_params.as_angle);
         start_params.as_angle /= DEG2RAD;
         //DriverHelper::GetParameterF("LutStride", start_params.LUT_stride);
-        std::string Lut_dataBuf;
-        DriverHelper::GetParameterS("LutDataBuf", Lut_dataBuf);
-        Lut_dataBuf.copy(LUT_user_data, sizeof(LUT_user_data), 0);
-        DriverHelper::ParseDriverLutData(Lut_dataBuf.c_str(), start_params.LUT_data_x, start_params.LUT_data_y);
+        start_params.LUT_size = DriverHelper::ReadLutData(start_params.LUT_data_x, start_params.LUT_data_y, start_params.LUT_size);
+        LUT_user_data = DriverHelper::EncodeLutData(start_params.LUT_data_x, start_params.LUT_data_y, start_params.LUT_size);
 
         start_params.use_anisotropy = start_params.sensY != start_params.sens;
 
@@ -1024,7 +1139,12 @@ int main() {
     }
 
 
+    for (auto &curve : curves)
+        curve = std::make_unique<CurveWorker::Curve>();
+    curve_worker.Start(GUI::Wake); // A finished curve is drawn right away, even while idle
+
     ResetParameters();
+    curve_worker.WaitIdle(); // The first frame already has all the curves
 
 
     while (true) {
@@ -1032,6 +1152,8 @@ int main() {
             break;
     }
 
+    speed_reader.Stop();
+    curve_worker.Stop();
     GUI::ShutDown();
 
     return 0;
@@ -3,6 +3,9 @@
 #ifndef SHARED_DEFINITIONS_H
 #define SHARED_DEFINITIONS_H
 
+#include <linux/types.h> // __u32, __s64... in both the kernel and userspace
+#include <linux/ioctl.h>
+
 enum AccelMode {
     AccelMode_Current = 0, // Mainly used in GUI, denotes lack of a curve on the driver side
     AccelMode_Linear = 1,
@@ -17,4 +20,104 @@ enum AccelMode {
     AccelMode_Count,
 };
 
+// How the LUT (and the Custom Curve, which is exported as one) is interpolated between its points
+enum LutInterpolation {
+    LutInterp_Linear = 0,
+    LutInterp_MonotoneCubic = 1, // Fritsch-Carlson, smooth and never overshoots the points
+    LutInterp_Count,
+};
+
+// Motion ring, a read-only mapping of /dev/yeetmouse_motion with a record of every accelerated frame (see driver/motion_ring.h).
+// The ring is only filled while the device is open.
+#define MOTION_RING_DEVICE "/dev/yeetmouse_motion"
+#define MOTION_RING_MAGIC 0x524D4D59 // "YMMR"
+#define MOTION_RING_VERSION 2
+#define MOTION_RING_SIZE 4096 // Number of records, a power of two
+
+struct motion_record {
+    __u64 seq;          // n + 1 once the n-th record is complete, 0 while it's being written
+    __u64 timestamp;    // Frame timestamp (ns, CLOCK_MONOTONIC)
+    __s32 dx, dy;       // Motion as reported by the device
+    __s64 speed;        // Input speed of the curve (counts/ms, Q32.32)
+    __s64 gain;         // Output of the curve (Q32.32)
+    __u32 device;       // N of the device's inputN (what /sys/class/input/eventM/device points to), MOTION_RECORD_NO_DEVICE if unknown
+    __u32 reserved;
+};
+
+#define MOTION_RECORD_NO_DEVICE 0xFFFFFFFF
+
+// To read the n-th record: read 'seq' (acquire), copy the record, then read 'seq' again.
+// The copy is good if both reads were n + 1, otherwise the record was overwritten in the meantime.
+struct motion_ring {
+    __u32 magic;
+    __u32 version;
+    __u32 size;         // MOTION_RING_SIZE
+    __u32 record_size;  // sizeof(struct motion_record)
+    __u64 head;         // Number of records written so far, the n-th one is records[n % size]
+    __u64 reserved[5];
+    struct motion_record records[];
+};
+
+// Binary configuration, set and read as a whole through ioctl() on /dev/yeetmouse_control. The driver validates it and
+// commits it atomically, the text parameters in /sys/module/yeetmouse/parameters/ are updated to match.
+#define YEETMOUSE_CONTROL_DEVICE "/dev/yeetmouse_control"
+#define YEETMOUSE_CONFIG_MAGIC 0x43464D59 // "YMFC"
+#define YEETMOUSE_CONFIG_VERSION 1
+#define YEETMOUSE_CONFIG_LUT_SIZE 4096 // Same as MAX_LUT_ARRAY_SIZE
+
+// Why a configuration was rejected, in the 'error' field
+enum yeetmouse_config_error {
+    YEETMOUSE_CONFIG_OK = 0,
+    YEETMOUSE_CONFIG_BAD_HEADER,        // Wrong magic or size
+    YEETMOUSE_CONFIG_BAD_VERSION,
+    YEETMOUSE_CONFIG_BAD_MODE,          // AccelerationMode out of range
+    YEETMOUSE_CONFIG_BAD_LUT_SIZE,      // Above YEETMOUSE_CONFIG_LUT_SIZE, or fewer than 2 points in a LUT mode
+    YEETMOUSE_CONFIG_LUT_UNSORTED,      // LutData_x is not sorted
+    YEETMOUSE_CONFIG_LUT_FLAT_END,      // The last two points have the same x
+    YEETMOUSE_CONFIG_BAD_ANGLE_SNAP,    // AngleSnap_Threshold out of [0, pi)
+    YEETMOUSE_CONFIG_BAD_PARAMETERS,    // The mode doesn't support these parameters (the kernel log says why)
+    YEETMOUSE_CONFIG_BAD_INTERPOLATION, // LutInterpolation out of range
+    YEETMOUSE_CONFIG_ERROR_COUNT
+};
+
+// All the values are Q32.32 fixed point, like the driver uses them
+struct yeetmouse_config {
+    __u32 magic;            // YEETMOUSE_CONFIG_MAGIC
+    __u32 version;          // YEETMOUSE_CONFIG_VERSION
+    __u32 size;             // sizeof(struct yeetmouse_config)
+    __u32 error;            // Set by the driver (enum yeetmouse_config_error)
+
+    __u8 AccelerationMode;  // enum AccelMode
+    __u8 UseSmoothing;
+    __u8 UseCurveTable;
+    __u8 LutInterpolation;  // enum LutInterpolation
+    __u8 reserved[4];
+
+    __s64 InputCap;
+    __s64 Sensitivity;
+    __s64 SensitivityY;
+    __s64 OutputCap;
+    __s64 Offset;
+    __s64 PreScale;
+
+    __s64 Acceleration;
+    __s64 Exponent;
+    __s64 Midpoint;
+    __s64 Motivity;
+
+    __s64 RotationAngle;
+    __s64 AngleSnap_Threshold;
+    __s64 AngleSnap_Angle;
+
+    __u32 LutSize;
+    __u32 reserved2;
+    __s64 LutData_x[YEETMOUSE_CONFIG_LUT_SIZE];
+    __s64 LutData_y[YEETMOUSE_CONFIG_LUT_SIZE];
+};
+
+// The argument is a pointer to a struct yeetmouse_config with the header filled in. On EINVAL, 'error' says why.
+// The struct is too big to have its size encoded in the number, the header's 'size' is checked instead.
+#define YEETMOUSE_IOC_SET_CONFIG _IO('Y', 0x01)
+#define YEETMOUSE_IOC_GET_CONFIG _IO('Y', 0x02)
+
 #endif
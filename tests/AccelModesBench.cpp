@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "shared_definitions.h"
+#include "driver/config.h"
+#include "driver/accel_modes.h"
+
+///
+/// Times every accel_* function over a realistic distribution of speeds and ranks the modes by their cost per call
+///
+/// Usage: AccelModesBench
+///
+/// Reports the mean ns per call (untimed loop, called through a function pointer like the driver does), p50, p99 and p99.9
+/// of the individually timed calls (with the timer overhead subtracted), and cycles, instructions and branch misses per call
+/// when perf_event_open() is available (see /proc/sys/kernel/perf_event_paranoid).
+///
+
+#define BENCH_SPEEDS 8192
+#define BENCH_REPS 32
+#define BENCH_TIMED_CALLS 200000
+
+struct Case {
+    std::string name;
+    std::unique_ptr<accel_params> params;
+    accel_fn fn;
+};
+
+struct Result {
+    std::string name;
+    double mean_ns;
+    double p50_ns, p99_ns, p999_ns;
+    double cycles, instructions, branch_misses; // Per call, negative when not available
+};
+
+// Counts/ms of an 8 kHz mouse in use, mostly slow and precise motion with a long tail of flicks
+static std::vector<FP_LONG> GenerateSpeeds() {
+    std::mt19937_64 rng(0x5EED);
+    std::lognormal_distribution<double> dist(std::log(3.0), 1.0);
+
+    std::vector<FP_LONG> speeds(BENCH_SPEEDS);
+    for (FP_LONG &speed : speeds)
+        speed = FP64_FromDouble(std::min(dist(rng), 300.0));
+    return speeds;
+}
+
+static std::unique_ptr<accel_params> MakeParams(AccelMode mode, bool smoothing, double accel, double exponent,
+                                                double midpoint, double motivity = 0) {
+    auto params = std::make_unique<accel_params>();
+    memset(params.get(), 0, sizeof(accel_params));
+    params->AccelerationMode = mode;
+    params->UseSmoothing = smoothing;
+    params->Sensitivity = params->SensitivityY = params->PreScale = FP64_1;
+    params->Acceleration = FP64_FromDouble(accel);
+    params->Exponent = FP64_FromDouble(exponent);
+    params->Midpoint = FP64_FromDouble(midpoint);
+    params->Motivity = FP64_FromDouble(motivity);
+    return params;
+}
+
+static std::unique_ptr<accel_params> MakeLutParams(unsigned long size) {
+    auto params = MakeParams(AccelMode_Lut, false, 0, 0, 0);
+    params->LutSize = size;
+    for (unsigned long i = 0; i < size; i++) {
+        double x = 100.0 * i / (size - 1);
+        params->LutData_x[i] = FP64_FromDouble(x);
+        params->LutData_y[i] = FP64_FromDouble(1 + 2 * x / (x + 20));
+    }
+    return params;
+}
+
+static void AddCase(std::vector<Case> &cases, std::string name, std::unique_ptr<accel_params> params) {
+    AccelMode mode = static_cast<AccelMode>(params->AccelerationMode);
+    update_constants(params.get());
+    if (params->AccelerationMode != mode) {
+        fprintf(stderr, "Invalid parameters for '%s', skipped\n", name.c_str());
+        return;
+    }
+
+    accel_fn direct = accel_select(params.get());
+    cases.push_back({name, std::move(params), direct});
+
+    // The same parameters through the compiled curve, which is what the driver uses when it's enabled
+    auto compiled = std::make_unique<accel_params>(*cases.back().params);
+    compiled->UseCurveTable = 1;
+    curve_table_build(compiled.get());
+    if (compiled->curve.valid) {
+        accel_fn fn = accel_select(compiled.get());
+        cases.push_back({name + ", compiled", std::move(compiled), fn});
+    }
+}
+
+static std::vector<Case> MakeCases() {
+    std::vector<Case> cases;
+
+    for (bool smoothing : {false, true}) {
+        std::string suffix = smoothing ? " (smooth)" : "";
+        AddCase(cases, "Linear" + suffix, MakeParams(AccelMode_Linear, smoothing, 0.05, 0, 2));
+        AddCase(cases, "Classic" + suffix, MakeParams(AccelMode_Classic, smoothing, 0.05, 2, 2));
+        AddCase(cases, "Synchronous" + suffix, MakeParams(AccelMode_Synchronous, smoothing, 10, 1, 0.5, 1.5));
+        AddCase(cases, "Natural" + suffix, MakeParams(AccelMode_Natural, smoothing, 0.1, 2, 2));
+        AddCase(cases, "Jump" + suffix, MakeParams(AccelMode_Jump, smoothing, 2, 0.2, 10));
+    }
+    AddCase(cases, "Power", MakeParams(AccelMode_Power, false, 0.1, 0.3, 1));
+    AddCase(cases, "Motivity", MakeParams(AccelMode_Motivity, false, 2, 0, 10));
+
+    for (unsigned long size = 8; size <= MAX_LUT_ARRAY_SIZE; size *= 2)
+        AddCase(cases, "LUT " + std::to_string(size) + " points", MakeLutParams(size));
+
+    return cases;
+}
+
+#ifdef __linux__
+///
+/// Cycles, instructions and branch misses of this thread (user space only), through perf_event_open()
+///
+class PerfCounters {
+public:
+    PerfCounters() {
+        const uint64_t configs[] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int i = 0; i < 3; i++) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = i == 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds[0], 0));
+            if (fds[i] < 0) {
+                Close();
+                return;
+            }
+        }
+    }
+
+    ~PerfCounters() { Close(); }
+
+    bool Available() const { return fds[0] >= 0; }
+
+    void Start() {
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    // Cycles, instructions and branch misses since Start()
+    bool Stop(uint64_t values[3]) {
+        ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        uint64_t data[4]; // nr, then the values in the order the events were opened
+        if (read(fds[0], data, sizeof(data)) != sizeof(data) || data[0] != 3)
+            return false;
+        std::copy(data + 1, data + 4, values);
+        return true;
+    }
+
+private:
+    void Close() {
+        for (int &fd : fds) {
+            if (fd >= 0)
+                close(fd);
+            fd = -1;
+        }
+    }
+
+    int fds[3] = {-1, -1, -1};
+};
+#else
+class PerfCounters {
+public:
+    bool Available() const { return false; }
+    void Start() {}
+    bool Stop(uint64_t values[3]) { return false; }
+};
+#endif
+
+static volatile FP_LONG sink;
+
+static FP_LONG RunLoop(const Case &c, const std::vector<FP_LONG> &speeds, int reps) {
+    FP_LONG acc = 0;
+    for (int r = 0; r < reps; r++)
+        for (FP_LONG speed : speeds)
+            acc ^= c.fn(c.params.get(), speed);
+    return acc;
+}
+
+static double Now() {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Median cost of an empty timed region
+static double TimerOverhead() {
+    std::vector<double> samples(BENCH_TIMED_CALLS / 10);
+    for (double &sample : samples) {
+        double start = Now();
+        sample = Now() - start;
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+static double Percentile(const std::vector<double> &sorted, double p) {
+    size_t index = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, index > 0 ? index - 1 : 0)];
+}
+
+static Result Measure(const Case &c, const std::vector<FP_LONG> &speeds, double overhead, PerfCounters &perf) {
+    Result result{c.name};
+    const double calls = static_cast<double>(speeds.size()) * BENCH_REPS;
+
+    sink = RunLoop(c, speeds, 1); // Warm up
+
+    double start = Now();
+    sink = RunLoop(c, speeds, BENCH_REPS);
+    result.mean_ns = (Now() - start) / calls;
+
+    result.cycles = result.instructions = result.branch_misses = -1;
+    uint64_t counters[3];
+    if (perf.Available()) {
+        perf.Start();
+        sink = RunLoop(c, speeds, BENCH_REPS);
+        if (perf.Stop(counters)) {
+            result.cycles = counters[0] / calls;
+            result.instructions = counters[1] / calls;
+            result.branch_misses = counters[2] / calls;
+        }
+    }
+
+    std::vector<double> samples(BENCH_TIMED_CALLS);
+    FP_LONG acc = 0;
+    for (int i = 0; i < BENCH_TIMED_CALLS; i++) {
+        FP_LONG speed = speeds[i % speeds.size()];
+        double call_start = Now();
+        acc ^= c.fn(c.params.get(), speed);
+        samples[i] = std::max(0.0, Now() - call_start - overhead);
+    }
+    sink = acc;
+
+    std::sort(samples.begin(), samples.end());
+    result.p50_ns = Percentile(samples, 50);
+    result.p99_ns = Percentile(samples, 99);
+    result.p999_ns = Percentile(samples, 99.9);
+
+    return result;
+}
+
+static void PrintCounter(double value) {
+    if (value < 0)
+        printf(" %9s", "-");
+    else
+        printf(" %9.1f", value);
+}
+
+int main() {
+    std::vector<FP_LONG> speeds = GenerateSpeeds();
+    std::vector<Case> cases = MakeCases();
+    PerfCounters perf;
+    double overhead = TimerOverhead();
+
+    std::vector<Result> results;
+    for (const Case &c : cases)
+        results.push_back(Measure(c, speeds, overhead, perf));
+
+    std::sort(results.begin(), results.end(), [](const Result &a, const Result &b) { return a.mean_ns < b.mean_ns; });
+
+    printf("Speeds: log-normal, median 3 counts/ms. Timer overhead: %.1f ns (subtracted from the percentiles)%s\n\n",
+           overhead, perf.Available() ? "" : ". Hardware counters not available");
+    printf("%-4s %-34s %9s %9s %9s %9s %9s %9s %9s\n", "#", "Mode", "mean ns", "p50", "p99", "p99.9", "cycles",
+           "instr", "br-miss");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        printf("%-4zu %-34s %9.1f %9.1f %9.1f %9.1f", i + 1, r.name.c_str(), r.mean_ns, r.p50_ns, r.p99_ns, r.p999_ns);
+        PrintCounter(r.cycles);
+        PrintCounter(r.instructions);
+        PrintCounter(r.branch_misses);
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "driver/config.h"
+#include "driver/FixedMath/Fixed64.h"
+
+///
+/// Measures the speed and the precision (against double) of the FP64_* functions on a small and a big input range
+///
+/// Usage: FixedMathBench [--csv file] [--json file] [--baseline file] [--time-threshold x] [--error-threshold x]
+///     --csv, --json - where to write the results ('-' for stdout). Without either, CSV goes to stdout
+///     --baseline - results of an earlier run (CSV), the run fails if any function regressed against them
+///     --time-threshold - allowed slowdown of ns/op against the baseline, 0.5 (50%) by default
+///     --error-threshold - allowed growth of the max errors against the baseline, 0.01 (1%) by default
+///
+
+#define BENCH_INPUTS 4096
+#define BENCH_REPS 16
+#define BENCH_RUNS 25 // Best one counts
+#define REL_ERROR_MIN_MAGNITUDE (1.0 / 65536) // Relative error is meaningless closer to 0, given the Q32.32 resolution
+#define FP64_LIMIT 2147483648.0
+
+struct Range {
+    const char *name;
+    double a_min, a_max;
+    double b_min, b_max;
+    bool log_scale; // Spread the inputs evenly over the magnitudes instead (positive ranges only)
+};
+
+struct Function {
+    const char *name;
+    FP_LONG (*call)(FP_LONG a, FP_LONG b);
+    double (*reference)(double a, double b);
+    FP_LONG (*loop)(const FP_LONG *a, const FP_LONG *b, int count, int reps);
+    Range small, big;
+};
+
+struct Result {
+    std::string function;
+    std::string range;
+    double ns_per_op = 0;
+    double cycles_per_op = 0;
+    double max_abs_error = 0, mean_abs_error = 0;
+    double max_rel_error = 0, mean_rel_error = 0;
+    size_t samples = 0; // Inputs with the reference result representable in Q32.32
+};
+
+// The call has to be visible to the compiler in the timed loop (so it's inlined like in the driver),
+// the results are folded together and returned, so that nothing can be optimized away
+#define FP_LOOP(expr) [](const FP_LONG *a, const FP_LONG *b, int count, int reps) {   \
+        FP_LONG acc = 0;                                                            \
+        for (int r = 0; r < reps; r++)                                              \
+            for (int i = 0; i < count; i++)                                         \
+                acc ^= (expr);                                                      \
+        return acc;                                                                 \
+    }
+
+#define UNARY(fn, ref, small, big) {#fn, [](FP_LONG a, FP_LONG) { return fn(a); },                          \
+        [](double a, double) { return ref; }, FP_LOOP(fn(a[i])), small, big}
+#define BINARY(fn, ref, small, big) {#fn, [](FP_LONG a, FP_LONG b) { return fn(a, b); },                     \
+        [](double a, double b) { return ref; }, FP_LOOP(fn(a[i], b[i])), small, big}
+
+#define R1(name, lo, hi) Range{name, lo, hi, 0, 0, false}
+#define R1_LOG(name, lo, hi) Range{name, lo, hi, 0, 0, true}
+#define R2(name, a_lo, a_hi, b_lo, b_hi) Range{name, a_lo, a_hi, b_lo, b_hi, false}
+
+static const Function functions[] = {
+    BINARY(FP64_Mul, a * b, R2("small", -100, 100, -100, 100), R2("big", -46000, 46000, -46000, 46000)),
+
+    BINARY(FP64_DivPrecise, a / b, R2("small", -100, 100, 0.01, 100), R2("big", -1e9, 1e9, 1, 1e6)),
+    BINARY(FP64_Div, a / b, R2("small", -100, 100, 0.01, 100), R2("big", -1e9, 1e9, 1, 1e6)),
+    BINARY(FP64_DivFast, a / b, R2("small", -100, 100, 0.01, 100), R2("big", -1e9, 1e9, 1, 1e6)),
+    BINARY(FP64_DivFastest, a / b, R2("small", -100, 100, 0.01, 100), R2("big", -1e9, 1e9, 1, 1e6)),
+    BINARY(FP64_DivNewton, a / b, R2("small", -100, 100, 0.01, 100), R2("big", -1e9, 1e9, 1, 1e6)),
+
+    UNARY(FP64_Rcp, 1 / a, R1_LOG("small", 0.01, 100), R1_LOG("big", 1, 1e9)),
+    UNARY(FP64_RcpFast, 1 / a, R1_LOG("small", 0.01, 100), R1_LOG("big", 1, 1e9)),
+    UNARY(FP64_RcpFastest, 1 / a, R1_LOG("small", 0.01, 100), R1_LOG("big", 1, 1e9)),
+
+    UNARY(FP64_SqrtPrecise, std::sqrt(a), R1("small", 0, 100), R1_LOG("big", 1, 2e9)),
+    UNARY(FP64_Sqrt, std::sqrt(a), R1("small", 0, 100), R1_LOG("big", 1, 2e9)),
+    UNARY(FP64_SqrtFast, std::sqrt(a), R1("small", 0, 100), R1_LOG("big", 1, 2e9)),
+    UNARY(FP64_SqrtFastest, std::sqrt(a), R1("small", 0, 100), R1_LOG("big", 1, 2e9)),
+
+    UNARY(FP64_RSqrt, 1 / std::sqrt(a), R1_LOG("small", 0.01, 100), R1_LOG("big", 1, 2e9)),
+    UNARY(FP64_RSqrtFast, 1 / std::sqrt(a), R1_LOG("small", 0.01, 100), R1_LOG("big", 1, 2e9)),
+    UNARY(FP64_RSqrtFastest, 1 / std::sqrt(a), R1_LOG("small", 0.01, 100), R1_LOG("big", 1, 2e9)),
+
+    UNARY(FP64_Exp, std::exp(a), R1("small", -10, 10), R1("big", -21, 21.4)),
+    UNARY(FP64_ExpFast, std::exp(a), R1("small", -10, 10), R1("big", -21, 21.4)),
+    UNARY(FP64_ExpFastest, std::exp(a), R1("small", -10, 10), R1("big", -21, 21.4)),
+    UNARY(FP64_Exp2, std::exp2(a), R1("small", -10, 10), R1("big", -31, 30.9)),
+    UNARY(FP64_Exp2Fast, std::exp2(a), R1("small", -10, 10), R1("big", -31, 30.9)),
+
+    UNARY(FP64_Log, std::log(a), R1_LOG("small", 0.01, 100), R1_LOG("big", 1e-6, 2e9)),
+    UNARY(FP64_LogFast, std::log(a), R1_LOG("small", 0.01, 100), R1_LOG("big", 1e-6, 2e9)),
+    UNARY(FP64_LogFastest, std::log(a), R1_LOG("small", 0.01, 100), R1_LOG("big", 1e-6, 2e9)),
+    UNARY(FP64_Log2, std::log2(a), R1_LOG("small", 0.01, 100), R1_LOG("big", 1e-6, 2e9)),
+    UNARY(FP64_Log2Fast, std::log2(a), R1_LOG("small", 0.01, 100), R1_LOG("big", 1e-6, 2e9)),
+    UNARY(FP64_Log2Fastest, std::log2(a), R1_LOG("small", 0.01, 100), R1_LOG("big", 1e-6, 2e9)),
+
+    BINARY(FP64_Pow, std::pow(a, b), R2("small", 0.01, 10, -3, 3), R2("big", 0.01, 1000, -3, 3)),
+    BINARY(FP64_PowFast, std::pow(a, b), R2("small", 0.01, 10, -3, 3), R2("big", 0.01, 1000, -3, 3)),
+    BINARY(FP64_PowFastest, std::pow(a, b), R2("small", 0.01, 10, -3, 3), R2("big", 0.01, 1000, -3, 3)),
+
+    UNARY(FP64_Sin, std::sin(a), R1("small", -2 * M_PI, 2 * M_PI), R1("big", -1000, 1000)),
+    UNARY(FP64_SinFast, std::sin(a), R1("small", -2 * M_PI, 2 * M_PI), R1("big", -1000, 1000)),
+    UNARY(FP64_SinFastest, std::sin(a), R1("small", -2 * M_PI, 2 * M_PI), R1("big", -1000, 1000)),
+    UNARY(FP64_Cos, std::cos(a), R1("small", -2 * M_PI, 2 * M_PI), R1("big", -1000, 1000)),
+    UNARY(FP64_CosFast, std::cos(a), R1("small", -2 * M_PI, 2 * M_PI), R1("big", -1000, 1000)),
+    UNARY(FP64_CosFastest, std::cos(a), R1("small", -2 * M_PI, 2 * M_PI), R1("big", -1000, 1000)),
+    UNARY(FP64_Tan, std::tan(a), R1("small", -1.5, 1.5), R1("big", -1000, 1000)),
+    UNARY(FP64_TanFast, std::tan(a), R1("small", -1.5, 1.5), R1("big", -1000, 1000)),
+    UNARY(FP64_TanFastest, std::tan(a), R1("small", -1.5, 1.5), R1("big", -1000, 1000)),
+
+    UNARY(FP64_Asin, std::asin(a), R1("small", -1, 1), R1("big", -1, 1)),
+    UNARY(FP64_AsinFast, std::asin(a), R1("small", -1, 1), R1("big", -1, 1)),
+    UNARY(FP64_AsinFastest, std::asin(a), R1("small", -1, 1), R1("big", -1, 1)),
+    UNARY(FP64_Acos, std::acos(a), R1("small", -1, 1), R1("big", -1, 1)),
+    UNARY(FP64_AcosFast, std::acos(a), R1("small", -1, 1), R1("big", -1, 1)),
+    UNARY(FP64_AcosFastest, std::acos(a), R1("small", -1, 1), R1("big", -1, 1)),
+    UNARY(FP64_Atan, std::atan(a), R1("small", -100, 100), R1("big", -1e9, 1e9)),
+    UNARY(FP64_AtanFast, std::atan(a), R1("small", -100, 100), R1("big", -1e9, 1e9)),
+    UNARY(FP64_AtanFastest, std::atan(a), R1("small", -100, 100), R1("big", -1e9, 1e9)),
+    BINARY(FP64_Atan2, std::atan2(a, b), R2("small", -100, 100, -100, 100), R2("big", -1e9, 1e9, -1e9, 1e9)),
+    BINARY(FP64_Atan2Fast, std::atan2(a, b), R2("small", -100, 100, -100, 100), R2("big", -1e9, 1e9, -1e9, 1e9)),
+    BINARY(FP64_Atan2Fastest, std::atan2(a, b), R2("small", -100, 100, -100, 100), R2("big", -1e9, 1e9, -1e9, 1e9)),
+
+    UNARY(FP64_Tanh, std::tanh(a), R1("small", -10, 10), R1("big", -1e9, 1e9)),
+};
+
+static double ToDouble(FP_LONG v) {
+    return static_cast<double>(v) / 4294967296.0;
+}
+
+static void GenerateInputs(const Range &range, std::vector<FP_LONG> &a, std::vector<FP_LONG> &b) {
+    std::mt19937_64 rng(0x5EED); // Same inputs on every run, so the errors are comparable
+    auto sample = [&](double lo, double hi) {
+        std::uniform_real_distribution<double> dist(0, 1);
+        double t = dist(rng);
+        if (range.log_scale)
+            return std::exp(std::log(lo) + t * (std::log(hi) - std::log(lo)));
+        return lo + t * (hi - lo);
+    };
+
+    a.resize(BENCH_INPUTS);
+    b.resize(BENCH_INPUTS);
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        a[i] = FP64_FromDouble(sample(range.a_min, range.a_max));
+        b[i] = range.b_min == range.b_max ? 0 : FP64_FromDouble(sample(range.b_min, range.b_max));
+    }
+}
+
+static uint64_t ReadCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc(); // TSC ticks, these match the core clock only with the frequency fixed
+#else
+    return 0;
+#endif
+}
+
+static volatile FP_LONG sink;
+
+static Result Measure(const Function &function, const Range &range) {
+    std::vector<FP_LONG> a, b;
+    GenerateInputs(range, a, b);
+
+    Result result{};
+    result.function = function.name;
+    result.range = range.name;
+
+    sink = function.loop(a.data(), b.data(), BENCH_INPUTS, 1); // Warm up
+
+    double best_ns = 1e18, best_cycles = 1e18;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t start_cycles = ReadCycles();
+        sink = function.loop(a.data(), b.data(), BENCH_INPUTS, BENCH_REPS);
+        uint64_t end_cycles = ReadCycles();
+        auto end = std::chrono::steady_clock::now();
+
+        best_ns = std::min(best_ns, std::chrono::duration<double, std::nano>(end - start).count());
+        best_cycles = std::min(best_cycles, static_cast<double>(end_cycles - start_cycles));
+    }
+    result.ns_per_op = best_ns / (BENCH_INPUTS * BENCH_REPS);
+    result.cycles_per_op = best_cycles / (BENCH_INPUTS * BENCH_REPS);
+
+    double abs_sum = 0, rel_sum = 0;
+    size_t rel_samples = 0;
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        // Compared against the exact result for the inputs after the conversion to fixed-point
+        double expected = function.reference(ToDouble(a[i]), ToDouble(b[i]));
+        if (!std::isfinite(expected) || std::abs(expected) >= FP64_LIMIT)
+            continue;
+
+        double abs_error = std::abs(ToDouble(function.call(a[i], b[i])) - expected);
+        result.max_abs_error = std::max(result.max_abs_error, abs_error);
+        abs_sum += abs_error;
+        result.samples++;
+
+        if (std::abs(expected) >= REL_ERROR_MIN_MAGNITUDE) {
+            double rel_error = abs_error / std::abs(expected);
+            result.max_rel_error = std::max(result.max_rel_error, rel_error);
+            rel_sum += rel_error;
+            rel_samples++;
+        }
+    }
+    result.mean_abs_error = result.samples ? abs_sum / result.samples : 0;
+    result.mean_rel_error = rel_samples ? rel_sum / rel_samples : 0;
+
+    return result;
+}
+
+static const char *csv_header =
+        "function,range,ns_per_op,cycles_per_op,max_abs_error,mean_abs_error,max_rel_error,mean_rel_error,samples";
+
+static void WriteCSV(FILE *file, const std::vector<Result> &results) {
+    fprintf(file, "%s\n", csv_header);
+    for (const Result &r : results) {
+        fprintf(file, "%s,%s,%.3f,%.3f,%.6e,%.6e,%.6e,%.6e,%zu\n", r.function.c_str(), r.range.c_str(), r.ns_per_op,
+                r.cycles_per_op, r.max_abs_error, r.mean_abs_error, r.max_rel_error, r.mean_rel_error, r.samples);
+    }
+}
+
+static void WriteJSON(FILE *file, const std::vector<Result> &results) {
+    fprintf(file, "[\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        fprintf(file, "  {\"function\": \"%s\", \"range\": \"%s\", \"ns_per_op\": %.3f, \"cycles_per_op\": %.3f, "
+                      "\"max_abs_error\": %.6e, \"mean_abs_error\": %.6e, \"max_rel_error\": %.6e, "
+                      "\"mean_rel_error\": %.6e, \"samples\": %zu}%s\n", r.function.c_str(), r.range.c_str(),
+                r.ns_per_op, r.cycles_per_op, r.max_abs_error, r.mean_abs_error, r.max_rel_error, r.mean_rel_error,
+                r.samples, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "]\n");
+}
+
+static bool Write(const char *path, const std::vector<Result> &results, void (*writer)(FILE *, const std::vector<Result> &)) {
+    if (strcmp(path, "-") == 0) {
+        writer(stdout, results);
+        return true;
+    }
+
+    FILE *file = fopen(path, "w");
+    if (!file)
+        return false;
+    writer(file, results);
+    fclose(file);
+    return true;
+}
+
+static bool LoadBaseline(const char *path, std::map<std::string, Result> &baseline) {
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return false;
+
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        char function[128], range[32];
+        Result r{};
+        if (sscanf(line, "%127[^,],%31[^,],%lf,%lf,%lf,%lf,%lf,%lf,%zu", function, range, &r.ns_per_op,
+                   &r.cycles_per_op, &r.max_abs_error, &r.mean_abs_error, &r.max_rel_error, &r.mean_rel_error,
+                   &r.samples) != 9)
+            continue; // Header
+        r.function = function;
+        r.range = range;
+        baseline[r.function + "/" + r.range] = r;
+    }
+
+    fclose(file);
+    return !baseline.empty();
+}
+
+// Errors are deterministic, so they are compared with a small threshold, while the timing gets a lot more leeway
+static int CompareToBaseline(const std::vector<Result> &results, const std::map<std::string, Result> &baseline,
+                             double time_threshold, double error_threshold) {
+    int regressions = 0;
+    auto worse = [](double value, double base, double threshold) {
+        return value > base * (1 + threshold) + 1e-12;
+    };
+
+    for (const Result &r : results) {
+        auto it = baseline.find(r.function + "/" + r.range);
+        if (it == baseline.end())
+            continue;
+        const Result &base = it->second;
+
+        if (worse(r.ns_per_op, base.ns_per_op, time_threshold)) {
+            fprintf(stderr, "%s (%s): %.3f ns/op, baseline %.3f\n", r.function.c_str(), r.range.c_str(), r.ns_per_op,
+                    base.ns_per_op);
+            regressions++;
+        }
+        if (worse(r.max_abs_error, base.max_abs_error, error_threshold) ||
+            worse(r.max_rel_error, base.max_rel_error, error_threshold)) {
+            fprintf(stderr, "%s (%s): max error %.6e abs / %.6e rel, baseline %.6e / %.6e\n", r.function.c_str(),
+                    r.range.c_str(), r.max_abs_error, r.max_rel_error, base.max_abs_error, base.max_rel_error);
+            regressions++;
+        }
+    }
+
+    return regressions;
+}
+
+static int Usage(const char *name) {
+    fprintf(stderr, "Usage: %s [--csv file] [--json file] [--baseline file] [--time-threshold x] "
+                    "[--error-threshold x]\n", name);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    const char *csv_path = nullptr, *json_path = nullptr, *baseline_path = nullptr;
+    double time_threshold = 0.5, error_threshold = 0.01;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc)
+            return Usage(argv[0]);
+        if (strcmp(argv[i], "--csv") == 0)
+            csv_path = argv[++i];
+        else if (strcmp(argv[i], "--json") == 0)
+            json_path = argv[++i];
+        else if (strcmp(argv[i], "--baseline") == 0)
+            baseline_path = argv[++i];
+        else if (strcmp(argv[i], "--time-threshold") == 0)
+            time_threshold = std::atof(argv[++i]);
+        else if (strcmp(argv[i], "--error-threshold") == 0)
+            error_threshold = std::atof(argv[++i]);
+        else
+            return Usage(argv[0]);
+    }
+    if (!csv_path && !json_path)
+        csv_path = "-";
+
+    std::vector<Result> results;
+    for (const Function &function : functions) {
+        results.push_back(Measure(function, function.small));
+        results.push_back(Measure(function, function.big));
+    }
+
+    if ((csv_path && !Write(csv_path, results, WriteCSV)) || (json_path && !Write(json_path, results, WriteJSON))) {
+        fprintf(stderr, "Couldn't write the results\n");
+        return 1;
+    }
+
+    if (baseline_path) {
+        std::map<std::string, Result> baseline;
+        if (!LoadBaseline(baseline_path, baseline)) {
+            fprintf(stderr, "Couldn't load the baseline from '%s'\n", baseline_path);
+            return 1;
+        }
+
+        int regressions = CompareToBaseline(results, baseline, time_threshold, error_threshold);
+        if (regressions > 0) {
+            fprintf(stderr, "%d regressions against the baseline\n", regressions);
+            return 1;
+        }
+    }
+
+    return 0;
+}
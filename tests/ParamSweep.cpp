@@ -0,0 +1,432 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "shared_definitions.h"
+#include "driver/config.h"
+#include "driver/accel_modes.h"
+#include "../gui/FunctionHelper.h"
+
+///
+/// Sweeps every acceleration mode over a grid of its parameters (the GUI's slider ranges) and speeds, and compares the
+/// driver's fixed-point curve against the GUI's float reference (CachedFunction::EvalFuncAt)
+///
+/// Usage: ParamSweep [-j threads] [-n points per parameter] [-s speeds per parameter set] [-t tolerance] [-c]
+///
+/// Reports per mode the worst relative error, the samples where either side is out of range (gain < 0, >= 1e5, NaN or inf)
+/// and the parameter sets update_constants() rejects. Every parameter set is a job for a pool of worker threads
+/// (one per core by default), each with its own accel_params and CachedFunction, so the results don't depend on the thread count.
+/// -c evaluates the driver through the compiled curve (accel_curve_eval) instead of directly.
+///
+
+#define SWEEP_MIN_SPEED 0.01
+#define SWEEP_MAX_SPEED 500.0
+#define SWEEP_MAX_GAIN 100000.0
+#define SWEEP_EXAMPLES 3
+
+struct Axis {
+    double min, max;
+    bool log; // Log-spaced, for the parameters that span orders of magnitude
+
+    double At(int i, int count) const {
+        if (count <= 1 || min == max)
+            return min;
+        double t = static_cast<double>(i) / (count - 1);
+        return log ? min * std::pow(max / min, t) : min + (max - min) * t;
+    }
+};
+
+static const char *const g_axis_names[] = {"Acceleration", "Exponent", "Midpoint", "Motivity"};
+#define AXIS_COUNT 4
+
+struct Case {
+    std::string name;
+    AccelMode mode;
+    bool smoothing;
+    Axis axes[AXIS_COUNT]; // Acceleration, Exponent, Midpoint and Motivity, a single value when the mode doesn't use it
+};
+
+static Axis Fixed(double value) { return {value, value, false}; }
+
+static std::vector<Case> MakeCases() {
+    std::vector<Case> cases;
+
+    // The modes with a smoothing (gain) option get a case for both
+    auto add_both = [&](const std::string &name, AccelMode mode, Axis accel, Axis exponent, Axis midpoint, Axis smooth_midpoint,
+                        Axis motivity) {
+        cases.push_back({name, mode, false, {accel, exponent, midpoint, motivity}});
+        cases.push_back({name + " (smooth)", mode, true, {accel, exponent, smooth_midpoint, motivity}});
+    };
+
+    add_both("Linear", AccelMode_Linear, {0.0005, 0.1, true}, Fixed(1), Fixed(0), {0.1, 50, true}, Fixed(1.5));
+    cases.push_back({"Power", AccelMode_Power, false, {{0.001, 5, true}, {0.01, 1, false}, {0, 5, false}, Fixed(1.5)}});
+    add_both("Classic", AccelMode_Classic, {0.001, 2, true}, {2.01, 5, false}, Fixed(0), {0.1, 50, true}, Fixed(1.5));
+    cases.push_back({"Motivity", AccelMode_Motivity, false, {{0.01, 10, true}, Fixed(1), {0.1, 50, true}, Fixed(1.5)}});
+    add_both("Synchronous", AccelMode_Synchronous, {0.01, 10, true}, {0.1, 20, true}, {0.1, 20, true}, {0.1, 20, true},
+             {1, 10, false});
+    add_both("Natural", AccelMode_Natural, {0.001, 5, true}, {0.01, 8, false}, {0, 50, false}, {0, 50, false}, Fixed(1.5));
+    add_both("Jump", AccelMode_Jump, {0, 10, false}, {0.01, 1, false}, {0.1, 50, true}, {0.1, 50, true}, Fixed(1.5));
+
+    return cases;
+}
+
+struct Options {
+    int threads = 0; // 0 = one per core
+    int points = 12;
+    int speeds = 256;
+    double tolerance = 0.001;
+    bool compiled = false;
+};
+
+// One parameter set of one case
+struct Job {
+    int c;
+    long set;
+};
+
+struct Sample {
+    long set = -1;
+    double values[AXIS_COUNT];
+    double speed;
+    double driver, reference;
+};
+
+// Out of range samples of one side, and the speeds they span
+struct Region {
+    long samples = 0;
+    long sets = 0;
+    double min_speed = INFINITY, max_speed = -INFINITY;
+    Sample first; // Lowest parameter set (and speed), to be independent of the order the jobs ran in
+
+    void Add(const Sample &s, bool new_set) {
+        samples++;
+        sets += new_set;
+        min_speed = std::min(min_speed, s.speed);
+        max_speed = std::max(max_speed, s.speed);
+        if (first.set < 0 || s.set < first.set)
+            first = s;
+    }
+
+    void Merge(const Region &other) {
+        samples += other.samples;
+        sets += other.sets;
+        min_speed = std::min(min_speed, other.min_speed);
+        max_speed = std::max(max_speed, other.max_speed);
+        if (other.first.set >= 0 && (first.set < 0 || other.first.set < first.set))
+            first = other.first;
+    }
+};
+
+struct CaseStats {
+    long sets = 0;
+    long samples = 0; // Compared, both sides in range
+    long over_tolerance = 0;
+    double error_sum = 0;
+    Sample worst; // driver and reference hold the values, error is recomputed
+    double worst_error = -1;
+
+    Region driver_out, reference_out;
+
+    long rejected = 0;
+    double rejected_min[AXIS_COUNT], rejected_max[AXIS_COUNT];
+    std::vector<long> rejected_sets; // Lowest SWEEP_EXAMPLES
+
+    CaseStats() {
+        std::fill(rejected_min, rejected_min + AXIS_COUNT, INFINITY);
+        std::fill(rejected_max, rejected_max + AXIS_COUNT, -INFINITY);
+    }
+
+    void AddRejected(long set, const double values[AXIS_COUNT]) {
+        rejected++;
+        for (int a = 0; a < AXIS_COUNT; a++) {
+            rejected_min[a] = std::min(rejected_min[a], values[a]);
+            rejected_max[a] = std::max(rejected_max[a], values[a]);
+        }
+        rejected_sets.push_back(set);
+        std::sort(rejected_sets.begin(), rejected_sets.end());
+        if (rejected_sets.size() > SWEEP_EXAMPLES)
+            rejected_sets.pop_back();
+    }
+
+    void Merge(const CaseStats &other) {
+        sets += other.sets;
+        samples += other.samples;
+        over_tolerance += other.over_tolerance;
+        error_sum += other.error_sum;
+        if (other.worst_error > worst_error || (other.worst_error == worst_error && other.worst.set < worst.set)) {
+            worst_error = other.worst_error;
+            worst = other.worst;
+        }
+        driver_out.Merge(other.driver_out);
+        reference_out.Merge(other.reference_out);
+
+        rejected += other.rejected;
+        for (int a = 0; a < AXIS_COUNT; a++) {
+            rejected_min[a] = std::min(rejected_min[a], other.rejected_min[a]);
+            rejected_max[a] = std::max(rejected_max[a], other.rejected_max[a]);
+        }
+        rejected_sets.insert(rejected_sets.end(), other.rejected_sets.begin(), other.rejected_sets.end());
+        std::sort(rejected_sets.begin(), rejected_sets.end());
+        if (rejected_sets.size() > SWEEP_EXAMPLES)
+            rejected_sets.resize(SWEEP_EXAMPLES);
+    }
+};
+
+static void SetValues(const Case &c, long set, int points, double values[AXIS_COUNT]) {
+    // The set index is a number in base 'points', one digit per axis (only the axes that vary)
+    for (int a = 0; a < AXIS_COUNT; a++) {
+        if (c.axes[a].min == c.axes[a].max) {
+            values[a] = c.axes[a].min;
+            continue;
+        }
+        values[a] = c.axes[a].At(static_cast<int>(set % points), points);
+        set /= points;
+    }
+}
+
+static long SetCount(const Case &c, int points) {
+    long count = 1;
+    for (const Axis &axis : c.axes)
+        if (axis.min != axis.max)
+            count *= points;
+    return count;
+}
+
+static double ToDouble(FP_LONG v) {
+    return static_cast<double>(v) / static_cast<double>(1ll << FP64_Shift);
+}
+
+static bool InRange(double gain) {
+    return std::isfinite(gain) && gain >= 0 && gain < SWEEP_MAX_GAIN;
+}
+
+///
+/// Everything a worker needs, so the workers share nothing but the job counter
+///
+class Worker {
+public:
+    explicit Worker(size_t cases) : stats(cases), driver(std::make_unique<accel_params>()),
+                                    reference_params(std::make_unique<Parameters>()) {
+        reference = CachedFunction(0, reference_params.get());
+    }
+
+    void Run(const Case &c, long set, int c_idx, const Options &options, const std::vector<double> &speeds) {
+        CaseStats &s = stats[c_idx];
+        double values[AXIS_COUNT];
+        SetValues(c, set, options.points, values);
+        s.sets++;
+
+        // The driver, the same way as a commit does it
+        memset(driver.get(), 0, sizeof(accel_params));
+        driver->AccelerationMode = c.mode;
+        driver->UseSmoothing = c.smoothing;
+        driver->UseCurveTable = options.compiled;
+        driver->Sensitivity = driver->SensitivityY = driver->PreScale = FP64_1;
+        driver->Acceleration = FP64_FromFloat(static_cast<float>(values[0]));
+        driver->Exponent = FP64_FromFloat(static_cast<float>(values[1]));
+        driver->Midpoint = FP64_FromFloat(static_cast<float>(values[2]));
+        driver->Motivity = FP64_FromFloat(static_cast<float>(values[3]));
+        update_constants(driver.get());
+        if (driver->AccelerationMode != c.mode) {
+            s.AddRejected(set, values);
+            return;
+        }
+        curve_table_build(driver.get());
+
+        // And the float reference with exactly the same (float) values
+        Parameters &p = *reference_params;
+        p.accelMode = c.mode;
+        p.useSmoothing = c.smoothing;
+        p.preScale = 1;
+        p.inCap = 0;
+        p.accel = static_cast<float>(values[0]);
+        p.exponent = static_cast<float>(values[1]);
+        p.midpoint = static_cast<float>(values[2]);
+        p.motivity = static_cast<float>(values[3]);
+        reference.PreCacheConstants();
+
+        bool driver_out = false, reference_out = false;
+        for (double speed : speeds) {
+            FP_LONG x = FP64_FromFloat(static_cast<float>(speed));
+            Sample sample{set, {}, ToDouble(x)};
+            std::copy(values, values + AXIS_COUNT, sample.values);
+            sample.driver = ToDouble(options.compiled ? accel_curve_eval(driver.get(), x) : accel_eval(driver.get(), x));
+            sample.reference = reference.EvalFuncAt(static_cast<float>(sample.speed));
+
+            bool driver_ok = InRange(sample.driver), reference_ok = InRange(sample.reference);
+            if (!driver_ok) {
+                s.driver_out.Add(sample, !driver_out);
+                driver_out = true;
+            }
+            if (!reference_ok) {
+                s.reference_out.Add(sample, !reference_out);
+                reference_out = true;
+            }
+            if (!driver_ok || !reference_ok)
+                continue;
+
+            double error = std::abs(sample.driver - sample.reference) / std::max(std::abs(sample.reference), 1e-3);
+            s.samples++;
+            s.error_sum += error;
+            s.over_tolerance += error > options.tolerance;
+            if (error > s.worst_error || (error == s.worst_error && set < s.worst.set)) {
+                s.worst_error = error;
+                s.worst = sample;
+            }
+        }
+    }
+
+    std::vector<CaseStats> stats;
+
+private:
+    std::unique_ptr<accel_params> driver;
+    std::unique_ptr<Parameters> reference_params;
+    CachedFunction reference;
+};
+
+static void PrintValues(const Case &c, const double values[AXIS_COUNT]) {
+    for (int a = 0; a < AXIS_COUNT; a++)
+        if (c.axes[a].min != c.axes[a].max)
+            printf(" %s %g", g_axis_names[a], values[a]);
+}
+
+static void PrintRegion(const Case &c, const char *side, const Region &region) {
+    if (region.samples == 0)
+        return;
+    printf("  %s out of range: %ld samples in %ld sets, speeds %g - %g, e.g.", side, region.samples, region.sets,
+           region.min_speed, region.max_speed);
+    PrintValues(c, region.first.values);
+    printf(" at speed %g (driver %g, float %g)\n", region.first.speed, region.first.driver, region.first.reference);
+}
+
+static void PrintCase(const Case &c, const CaseStats &s, const Options &options) {
+    printf("%s: %ld sets, %ld rejected by update_constants(), %ld samples compared\n", c.name.c_str(), s.sets, s.rejected,
+           s.samples);
+
+    if (s.samples > 0) {
+        printf("  relative error: worst %.3g, mean %.3g, %ld samples over %g\n", s.worst_error, s.error_sum / s.samples,
+               s.over_tolerance, options.tolerance);
+        printf("  worst at");
+        PrintValues(c, s.worst.values);
+        printf(" speed %g (driver %.9g, float %.9g)\n", s.worst.speed, s.worst.driver, s.worst.reference);
+    }
+
+    PrintRegion(c, "driver", s.driver_out);
+    PrintRegion(c, "float", s.reference_out);
+
+    if (s.rejected > 0) {
+        printf("  rejected within");
+        for (int a = 0; a < AXIS_COUNT; a++)
+            if (c.axes[a].min != c.axes[a].max)
+                printf(" %s [%g, %g]", g_axis_names[a], s.rejected_min[a], s.rejected_max[a]);
+        printf(", e.g.");
+        for (size_t i = 0; i < s.rejected_sets.size(); i++) {
+            double values[AXIS_COUNT];
+            SetValues(c, s.rejected_sets[i], options.points, values);
+            printf(i ? ";" : "");
+            PrintValues(c, values);
+        }
+        printf("\n");
+    }
+}
+
+static bool ParseArgs(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-c") {
+            options.compiled = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            return false;
+        const char *value = argv[++i];
+        if (arg == "-j")
+            options.threads = atoi(value);
+        else if (arg == "-n")
+            options.points = atoi(value);
+        else if (arg == "-s")
+            options.speeds = atoi(value);
+        else if (arg == "-t")
+            options.tolerance = atof(value);
+        else
+            return false;
+    }
+    return options.threads >= 0 && options.points >= 2 && options.speeds >= 2 && options.tolerance > 0;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!ParseArgs(argc, argv, options)) {
+        fprintf(stderr, "Usage: %s [-j threads] [-n points per parameter] [-s speeds per parameter set] [-t tolerance] [-c]\n",
+                argv[0]);
+        return 1;
+    }
+    if (options.threads == 0)
+        options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::vector<Case> cases = MakeCases();
+
+    // Log-spaced, most of the motion is slow
+    std::vector<double> speeds(options.speeds);
+    for (int i = 0; i < options.speeds; i++)
+        speeds[i] = SWEEP_MIN_SPEED * std::pow(SWEEP_MAX_SPEED / SWEEP_MIN_SPEED, static_cast<double>(i) / (options.speeds - 1));
+
+    std::vector<Job> jobs;
+    for (int c = 0; c < static_cast<int>(cases.size()); c++)
+        for (long set = 0; set < SetCount(cases[c], options.points); set++)
+            jobs.push_back({c, set});
+
+    // update_constants() reports every rejection with printk (printf here), they are counted instead
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+        dup2(null_fd, STDOUT_FILENO);
+        close(null_fd);
+    }
+
+    // The pool, the workers take the next job until there are none left
+    std::atomic<size_t> next{0};
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < options.threads; t++) {
+        workers.push_back(std::make_unique<Worker>(cases.size()));
+        threads.emplace_back([&, worker = workers.back().get()] {
+            for (size_t j; (j = next.fetch_add(1, std::memory_order_relaxed)) < jobs.size();)
+                worker->Run(cases[jobs[j].c], jobs[j].set, jobs[j].c, options, speeds);
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+
+    std::vector<CaseStats> stats(cases.size());
+    for (const auto &worker : workers)
+        for (size_t c = 0; c < cases.size(); c++)
+            stats[c].Merge(worker->stats[c]);
+
+    printf("%zu parameter sets x %d speeds (%g - %g counts/ms), %s, %d threads, %.2f s\n\n", jobs.size(), options.speeds,
+           SWEEP_MIN_SPEED, SWEEP_MAX_SPEED, options.compiled ? "compiled curve" : "direct", options.threads, seconds);
+    for (size_t c = 0; c < cases.size(); c++)
+        PrintCase(cases[c], stats[c], options);
+
+    return 0;
+}
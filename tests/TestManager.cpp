@@ -3,11 +3,8 @@
 #include "shared_definitions.h"
 #include "driver/accel_modes.h"
 
-// "Private" values only visible to the accel_modes
-FP_LONG g_Acceleration = 0, g_Exponent = 0, g_Midpoint = 0, g_Motivity = 0, g_RotationAngle = 0, g_AngleSnap_Angle = 0, g_AngleSnap_Threshold = 0, g_LutData_x[256], g_LutData_y[256];
-char g_AccelerationMode = 0, g_UseSmoothing = 0;
-unsigned long g_LutSize = 0;
-ModesConstants modesConst;
+// Stand-in for the parameter snapshot the driver publishes
+static accel_params driver_params;
 static CachedFunction function;
 
 // TestManager & TestManager::GetInstance() {
@@ -19,16 +16,16 @@ void TestManager::Initialize() {
     function.params = new Parameters;
     function.params->sens = 1;
     function.params->sensY = 1;
-    function.params->accelMode = static_cast<AccelMode>(g_AccelerationMode);
+    function.params->accelMode = static_cast<AccelMode>(driver_params.AccelerationMode);
     function.params->preScale = 1;
-    function.params->accel = FP64_ToFloat(g_Acceleration);
-    function.params->exponent = FP64_ToFloat(g_Exponent);
-    function.params->midpoint = FP64_ToFloat(g_Midpoint);
+    function.params->accel = FP64_ToFloat(driver_params.Acceleration);
+    function.params->exponent = FP64_ToFloat(driver_params.Exponent);
+    function.params->midpoint = FP64_ToFloat(driver_params.Midpoint);
     function.params->offset = 0;
-    function.params->useSmoothing = g_UseSmoothing;
-    function.params->rotation = FP64_ToFloat(g_RotationAngle);
-    function.params->as_angle = FP64_ToFloat(g_AngleSnap_Angle);
-    function.params->as_threshold = FP64_ToFloat(g_AngleSnap_Threshold);
+    function.params->useSmoothing = driver_params.UseSmoothing;
+    function.params->rotation = FP64_ToFloat(driver_params.RotationAngle);
+    function.params->as_angle = FP64_ToFloat(driver_params.AngleSnap_Angle);
+    function.params->as_threshold = FP64_ToFloat(driver_params.AngleSnap_Threshold);
     function.params->inCap = 0;
     function.params->outCap = 0;
     function.PreCacheConstants();
@@ -39,7 +36,7 @@ FP_LONG TestManager::AccelLinear(FP_LONG x, FP_LONG acceleration, bool gain, FP_
     SetUseSmoothing(gain);
     SetMidpoint(midpoint);
     UpdateModesConstants();
-    return accel_linear(x);
+    return accel_linear(&driver_params, x);
 }
 
 FP_LONG TestManager::AccelPower(FP_LONG x, FP_LONG acceleration, FP_LONG exponent, FP_LONG midpoint) {
@@ -47,14 +44,14 @@ FP_LONG TestManager::AccelPower(FP_LONG x, FP_LONG acceleration, FP_LONG exponen
     SetExponent(exponent);
     SetMidpoint(midpoint);
     UpdateModesConstants();
-    return accel_power(x);
+    return accel_power(&driver_params, x);
 }
 
 FP_LONG TestManager::AccelClassic(FP_LONG x, FP_LONG acceleration, FP_LONG exponent) {
     SetAcceleration(acceleration);
     SetExponent(exponent);
     UpdateModesConstants();
-    return accel_classic(x);
+    return accel_classic(&driver_params, x);
 }
 
 FP_LONG TestManager::AccelMotivity(FP_LONG x, FP_LONG acceleration, FP_LONG exponent, FP_LONG midpoint) {
@@ -62,7 +59,7 @@ FP_LONG TestManager::AccelMotivity(FP_LONG x, FP_LONG acceleration, FP_LONG expo
     SetExponent(exponent);
     SetMidpoint(midpoint);
     UpdateModesConstants();
-    return accel_motivity(x);
+    return accel_motivity(&driver_params, x);
 }
 
 FP_LONG TestManager::AccelSynchronous(FP_LONG x, FP_LONG sync_speed, FP_LONG gamma, FP_LONG smoothness, FP_LONG motivity, bool gain) {
@@ -72,7 +69,7 @@ FP_LONG TestManager::AccelSynchronous(FP_LONG x, FP_LONG sync_speed, FP_LONG gam
     SetMotivity(motivity);
     SetUseSmoothing(gain);
     UpdateModesConstants();
-    return accel_motivity(x);
+    return accel_motivity(&driver_params, x);
 }
 
 FP_LONG TestManager::AccelJump(FP_LONG x, FP_LONG acceleration, FP_LONG exponent, FP_LONG midpoint, bool gain) {
@@ -81,7 +78,7 @@ FP_LONG TestManager::AccelJump(FP_LONG x, FP_LONG acceleration, FP_LONG exponent
     SetMidpoint(midpoint);
     SetUseSmoothing(gain);
     UpdateModesConstants();
-    return accel_jump(x);
+    return accel_jump(&driver_params, x);
 }
 
 FP_LONG TestManager::AccelLUT(FP_LONG x, FP_LONG values_x[], FP_LONG values_y[], unsigned long count) {
@@ -89,11 +86,11 @@ FP_LONG TestManager::AccelLUT(FP_LONG x, FP_LONG values_x[], FP_LONG values_y[],
     SetLutData_x(values_x, count);
     SetLutData_y(values_y, count);
     UpdateModesConstants();
-    return accel_lut(x);
+    return accel_lut(&driver_params, x);
 }
 
 FP_LONG TestManager::AccelLUT(FP_LONG x) {
-    return accel_lut(x);
+    return accel_lut(&driver_params, x);
 }
 
 FP_LONG TestManager::AccelLinear(float x, float acceleration, bool gain, float midpoint) {
@@ -139,47 +136,86 @@ FP_LONG TestManager::AccelLUT(float x) {
 }
 
 FP_LONG TestManager::AccelLinear(float x) {
-    return accel_linear(FP64_FromFloat(x));
+    return accel_linear(&driver_params, FP64_FromFloat(x));
 }
 
 FP_LONG TestManager::AccelPower(float x) {
-    return accel_power(FP64_FromFloat(x));
+    return accel_power(&driver_params, FP64_FromFloat(x));
 }
 
 FP_LONG TestManager::AccelClassic(float x) {
-    return accel_classic(FP64_FromFloat(x));
+    return accel_classic(&driver_params, FP64_FromFloat(x));
 }
 
 FP_LONG TestManager::AccelMotivity(float x) {
-    return accel_motivity(FP64_FromFloat(x));
+    return accel_motivity(&driver_params, FP64_FromFloat(x));
 }
 
 FP_LONG TestManager::AccelSynchronous(float x) {
-    return accel_synchronous(FP64_FromFloat(x));
+    return accel_synchronous(&driver_params, FP64_FromFloat(x));
 }
 
 FP_LONG TestManager::AccelNatural(float x) {
-    return accel_natural(FP64_FromFloat(x));
+    return accel_natural(&driver_params, FP64_FromFloat(x));
 }
 
 FP_LONG TestManager::AccelJump(float x) {
-    return accel_jump(FP64_FromFloat(x));
+    return accel_jump(&driver_params, FP64_FromFloat(x));
+}
+
+FP_LONG TestManager::AccelDirect(float x) {
+    return accel_eval(&driver_params, FP64_FromFloat(x));
+}
+
+FP_LONG TestManager::AccelCompiled(float x) {
+    return accel_curve_eval(&driver_params, FP64_FromFloat(x));
+}
+
+void TestManager::AccelBatch(const FP_LONG speeds[], FP_LONG out[], size_t count) {
+    accel_eval_batch(&driver_params, speeds, out, count);
+}
+
+void TestManager::AccelOutput(FP_LONG& x, FP_LONG& y) {
+    // Same as the tail of accelerate(), with the gain of 1
+    const ModesConstants& constants = driver_params.modesConst;
+    FP_LONG magnitude;
+
+    x = FP64_Mul(x, constants.gain_sens);
+    y = FP64_Mul(y, constants.gain_sens);
+
+    if (constants.use_transform) {
+        FP_LONG scaled_x = FP64_Mul(x, driver_params.Sensitivity);
+        FP_LONG scaled_y = FP64_Mul(y, driver_params.SensitivityY);
+        magnitude = FP64_Sqrt(FP64_Add(FP64_Mul(scaled_x, scaled_x), FP64_Mul(scaled_y, scaled_y)));
+    }
+    else
+        magnitude = FP64_Sqrt(FP64_Add(FP64_Mul(x, x), FP64_Mul(y, y)));
+
+    bool snapped = driver_params.AngleSnap_Threshold != 0 && angle_snap(&driver_params, &x, &y, magnitude);
+
+    if (constants.use_transform && !snapped)
+        accel_transform(&driver_params, &x, &y);
 }
 
 ModesConstants& TestManager::GetModesConstants() {
-    return modesConst;
+    return driver_params.modesConst;
+}
+
+const curve_table& TestManager::GetCurveTable() {
+    return driver_params.curve;
 }
 
 void TestManager::UpdateModesConstants() {
-    update_constants();
+    update_constants(&driver_params);
+    curve_table_build(&driver_params);
     function.PreCacheConstants();
 }
 
 bool TestManager::ValidateConstants() {
-    if (g_AccelerationMode == AccelMode_Current)
+    if (driver_params.AccelerationMode == AccelMode_Current)
         return false;
 
-    // switch (g_AccelerationMode) {
+    // switch (driver_params.AccelerationMode) {
     //     case AccelMode_Linear:
     //         break;
     //     case AccelMode_Power:
@@ -202,65 +238,81 @@ bool TestManager::ValidateFunctionGUI() {
 }
 
 void TestManager::SetAccelMode(AccelMode mode) {
-    g_AccelerationMode = mode;
-    function.params->accelMode = static_cast<AccelMode>(g_AccelerationMode);
+    driver_params.AccelerationMode = mode;
+    function.params->accelMode = static_cast<AccelMode>(driver_params.AccelerationMode);
 }
 
 void TestManager::SetUseSmoothing(char useSmoothing) {
-    g_UseSmoothing = useSmoothing;
-    function.params->useSmoothing = g_UseSmoothing;
+    driver_params.UseSmoothing = useSmoothing;
+    function.params->useSmoothing = driver_params.UseSmoothing;
 }
 
 void TestManager::SetAcceleration(FP_LONG acceleration) {
-    g_Acceleration = acceleration;
-    function.params->accel = FP64_ToFloat(g_Acceleration);
+    driver_params.Acceleration = acceleration;
+    function.params->accel = FP64_ToFloat(driver_params.Acceleration);
 }
 
 void TestManager::SetExponent(FP_LONG exponent) {
-    g_Exponent = exponent;
-    function.params->exponent = FP64_ToFloat(g_Exponent);
+    driver_params.Exponent = exponent;
+    function.params->exponent = FP64_ToFloat(driver_params.Exponent);
 }
 
 void TestManager::SetMidpoint(FP_LONG midpoint) {
-    g_Midpoint = midpoint;
-    function.params->midpoint = FP64_ToFloat(g_Midpoint);
+    driver_params.Midpoint = midpoint;
+    function.params->midpoint = FP64_ToFloat(driver_params.Midpoint);
 }
 
 void TestManager::SetMotivity(FP_LONG motivity) {
-    g_Motivity = motivity;
-    function.params->motivity = FP64_ToFloat(g_Motivity);
+    driver_params.Motivity = motivity;
+    function.params->motivity = FP64_ToFloat(driver_params.Motivity);
+}
+
+void TestManager::SetSensitivity(FP_LONG sensitivity, FP_LONG sensitivityY) {
+    driver_params.Sensitivity = sensitivity;
+    driver_params.SensitivityY = sensitivityY;
+    function.params->sens = FP64_ToFloat(driver_params.Sensitivity);
+    function.params->sensY = FP64_ToFloat(driver_params.SensitivityY);
 }
 
 void TestManager::SetRotationAngle(FP_LONG rotationAngle) {
-    g_RotationAngle = rotationAngle;
-    function.params->rotation = FP64_ToFloat(g_RotationAngle);
+    driver_params.RotationAngle = rotationAngle;
+    function.params->rotation = FP64_ToFloat(driver_params.RotationAngle);
 }
 
 void TestManager::SetAngleSnap_Angle(FP_LONG angleSnap_Angle) {
-    g_AngleSnap_Angle = angleSnap_Angle;
-    function.params->as_angle = FP64_ToFloat(g_AngleSnap_Angle);
+    driver_params.AngleSnap_Angle = angleSnap_Angle;
+    function.params->as_angle = FP64_ToFloat(driver_params.AngleSnap_Angle);
 }
 
 void TestManager::SetAngleSnap_Threshold(FP_LONG angleSnap_Threshold) {
-    g_AngleSnap_Threshold = angleSnap_Threshold;
-    function.params->as_threshold = FP64_ToFloat(g_AngleSnap_Threshold);
+    driver_params.AngleSnap_Threshold = angleSnap_Threshold;
+    function.params->as_threshold = FP64_ToFloat(driver_params.AngleSnap_Threshold);
 }
 
 void TestManager::SetUseSmoothing(bool useSmoothing) {
-    g_UseSmoothing = useSmoothing ? 1 : 0;
-    function.params->useSmoothing = g_UseSmoothing;
+    driver_params.UseSmoothing = useSmoothing ? 1 : 0;
+    function.params->useSmoothing = driver_params.UseSmoothing;
+}
+
+void TestManager::SetUseCurveTable(bool useCurveTable) {
+    driver_params.UseCurveTable = useCurveTable ? 1 : 0;
 }
 
 void TestManager::SetLutSize(unsigned long lutSize) {
-    g_LutSize = lutSize;
-    function.params->LUT_size = g_LutSize;
+    driver_params.LutSize = lutSize;
+    function.params->LUT_size = driver_params.LutSize;
+}
+
+void TestManager::SetLutInterpolation(LutInterpolation interpolation) {
+    driver_params.LutInterpolation = interpolation;
+    function.params->lutInterpolation = interpolation;
 }
 
 void TestManager::SetLutData_x(FP_LONG values[], unsigned long count) {
     SetLutSize(count);
 
     for (unsigned long i = 0; i < count; i++) {
-        g_LutData_x[i] = values[i];
+        driver_params.LutData_x[i] = values[i];
         function.params->LUT_data_x[i] = FP64_ToFloat(values[i]);
     }
 }
@@ -269,7 +321,7 @@ void TestManager::SetLutData_y(FP_LONG values[], unsigned long count) {
     SetLutSize(count);
 
     for (unsigned long i = 0; i < count; i++) {
-        g_LutData_y[i] = values[i];
+        driver_params.LutData_y[i] = values[i];
         function.params->LUT_data_y[i] = FP64_ToFloat(values[i]);
     }
 }
@@ -296,6 +348,10 @@ void TestManager::SetMotivity(float motivity) {
     SetMotivity(FP64_FromFloat(motivity));
 }
 
+void TestManager::SetSensitivity(float sensitivity, float sensitivityY) {
+    SetSensitivity(FP64_FromFloat(sensitivity), FP64_FromFloat(sensitivityY));
+}
+
 void TestManager::SetRotationAngle(float rotationAngle) {
     SetRotationAngle(FP64_FromFloat(rotationAngle));
 }
@@ -321,36 +377,36 @@ void TestManager::SetLutData(float values_x[], float values_y[], unsigned long c
 }
 
 float TestManager::EvalFloatFunc(float x) {
-    function.params->accelMode = static_cast<AccelMode>(g_AccelerationMode);
+    function.params->accelMode = static_cast<AccelMode>(driver_params.AccelerationMode);
     return function.EvalFuncAt(x);
 }
 
 // float TestManager::EvalFloatLinear(float x) {
-//     function.params->accelMode = static_cast<AccelMode>(g_AccelerationMode);
+//     function.params->accelMode = static_cast<AccelMode>(driver_params.AccelerationMode);
 //     return function.EvalFuncAt(x);
 // }
 //
 // float TestManager::EvalFloatPower(float x) {
-//     function.params->accelMode = static_cast<AccelMode>(g_AccelerationMode);
+//     function.params->accelMode = static_cast<AccelMode>(driver_params.AccelerationMode);
 //     return function.EvalFuncAt(x);
 // }
 //
 // float TestManager::EvalFloatClassic(float x) {
-//     function.params->accelMode = static_cast<AccelMode>(g_AccelerationMode);
+//     function.params->accelMode = static_cast<AccelMode>(driver_params.AccelerationMode);
 //     return function.EvalFuncAt(x);
 // }
 //
 // float TestManager::EvalFloatMotivity(float x) {
-//     function.params->accelMode = static_cast<AccelMode>(g_AccelerationMode);
+//     function.params->accelMode = static_cast<AccelMode>(driver_params.AccelerationMode);
 //     return function.EvalFuncAt(x);
 // }
 //
 // float TestManager::EvalFloatJump(float x) {
-//     function.params->accelMode = static_cast<AccelMode>(g_AccelerationMode);
+//     function.params->accelMode = static_cast<AccelMode>(driver_params.AccelerationMode);
 //     return function.EvalFuncAt(x);
 // }
 //
 // float TestManager::EvalFloatLUT(float x) {
-//     function.params->accelMode = static_cast<AccelMode>(g_AccelerationMode);
+//     function.params->accelMode = static_cast<AccelMode>(driver_params.AccelerationMode);
 //     return function.EvalFuncAt(x);
 // }
@@ -40,7 +40,14 @@ class TestManager {
     static FP_LONG AccelJump(float x); // Parameter values set manually!
     static FP_LONG AccelLUT(float x); // Parameter values set manually!
 
+    static FP_LONG AccelDirect(float x); // Active mode, parameter values set manually!
+    static FP_LONG AccelCompiled(float x); // Active mode through the compiled curve, parameter values set manually!
+    static void AccelBatch(const FP_LONG speeds[], FP_LONG out[], size_t count); // accel_eval_batch(), parameter values set manually!
+
+    static void AccelOutput(FP_LONG& x, FP_LONG& y); // Sensitivity, angle snapping and rotation, parameter values set manually!
+
     static ModesConstants& GetModesConstants();
+    static const curve_table& GetCurveTable();
     static void UpdateModesConstants();
     static bool ValidateConstants();
     static bool ValidateFunctionGUI();
@@ -51,11 +58,14 @@ class TestManager {
     static void SetExponent(FP_LONG exponent);
     static void SetMidpoint(FP_LONG midpoint);
     static void SetMotivity(FP_LONG motivity);
+    static void SetSensitivity(FP_LONG sensitivity, FP_LONG sensitivityY);
     static void SetRotationAngle(FP_LONG rotationAngle);
     static void SetAngleSnap_Angle(FP_LONG angleSnap_Angle);
     static void SetAngleSnap_Threshold(FP_LONG angleSnap_Threshold);
     static void SetUseSmoothing(bool useSmoothing);
+    static void SetUseCurveTable(bool useCurveTable);
     static void SetLutSize(unsigned long lutSize);
+    static void SetLutInterpolation(LutInterpolation interpolation);
     static void SetLutData_x(FP_LONG values[], unsigned long count);
     static void SetLutData_y(FP_LONG values[], unsigned long count);
     static void SetLutData(FP_LONG values_x[], FP_LONG values_y[], unsigned long count);
@@ -64,6 +74,7 @@ class TestManager {
     static void SetExponent(float exponent);
     static void SetMidpoint(float midpoint);
     static void SetMotivity(float motivity);
+    static void SetSensitivity(float sensitivity, float sensitivityY);
     static void SetRotationAngle(float rotationAngle);
     static void SetAngleSnap_Angle(float angleSnap_Angle);
     static void SetAngleSnap_Threshold(float angleSnap_Threshold);
@@ -2,6 +2,8 @@
 
 #include <array>
 #include <cmath>
+#include <filesystem>
+#include <fstream>
 
 #include "TestManager.h"
 #include "driver/accel_modes.h"
@@ -434,6 +436,32 @@ bool Tests::TestAccelSynchronous(float range_min, float range_max) {
 
         supervisor.NextTest();
 
+        // The smoothing table has to follow the parameters (gamma, motivity and sync speed changed)
+        FP_LONG previous = TestManager::AccelSynchronous(2.f);
+
+        TestManager::SetAccelMode(AccelMode_Synchronous);
+        TestManager::SetExponent(0.5f);
+        TestManager::SetMidpoint(0.5f);
+        TestManager::SetMotivity(3.f);
+        TestManager::SetAcceleration(10.f);
+        TestManager::SetUseSmoothing(true);
+        TestManager::UpdateModesConstants();
+
+        if (TestManager::AccelSynchronous(2.f) == previous) {
+            fprintf(stderr, "Smoothing table did not change with the parameters\n");
+            supervisor.result = false;
+        }
+
+        for (int i = 1; i <= BASIC_TEST_STEPS; i++) {
+            float x = range_min + static_cast<float>(i) * (range_max - range_min) / BASIC_TEST_STEPS;
+            auto res = TestManager::AccelSynchronous(x);
+
+            supervisor.result &= IsAccelValueGood(res);
+            supervisor.result &= IsCloseEnoughRelative(res, TestManager::EvalFloatFunc(x));
+        }
+
+        supervisor.NextTest();
+
         TestManager::SetAccelMode(AccelMode_Synchronous);
         TestManager::SetExponent(20.f);
         TestManager::SetMidpoint(4.f);
@@ -663,6 +691,58 @@ bool Tests::TestAccelLUT(float range_min, float range_max) {
 
         supervisor.NextTest();
 
+        // A full size LUT of a smooth curve with uneven spacing, resampled onto the grid by the driver
+        static float values_x_big[MAX_LUT_ARRAY_SIZE], values_y_big[MAX_LUT_ARRAY_SIZE];
+        for (int i = 0; i < MAX_LUT_ARRAY_SIZE; i++) {
+            float t = static_cast<float>(i) / (MAX_LUT_ARRAY_SIZE - 1);
+            values_x_big[i] = 0.5f + range_max * t * t;
+            values_y_big[i] = 1 + 2 * values_x_big[i] / (values_x_big[i] + 20);
+        }
+        TestManager::SetAccelMode(AccelMode_Lut);
+        TestManager::SetLutData(values_x_big, values_y_big, MAX_LUT_ARRAY_SIZE);
+        TestManager::UpdateModesConstants();
+
+        for (int i = 0; i < BASIC_TEST_STEPS; i++) {
+            float value = range_min + static_cast<float>(i) * (range_max - range_min) / BASIC_TEST_STEPS;
+            auto res = TestManager::AccelLUT(value);
+
+            supervisor.result &= IsAccelValueGood(res);
+            supervisor.result &= IsCloseEnoughRelative(res, TestManager::EvalFloatFunc(value));
+        }
+
+        supervisor.NextTest();
+
+        // A handful of points along the monotone cubic has to follow the curve closely and never overshoot
+        float values_x_cubic[] = {0.5, 2, 5, 10, 20, 40, 80, 150};
+        float values_y_cubic[std::size(values_x_cubic)];
+        for (size_t i = 0; i < std::size(values_x_cubic); i++)
+            values_y_cubic[i] = 1 + 2 * values_x_cubic[i] / (values_x_cubic[i] + 20);
+        values_y_cubic[1] = values_y_cubic[2]; // A flat part
+
+        TestManager::SetAccelMode(AccelMode_Lut);
+        TestManager::SetLutInterpolation(LutInterp_MonotoneCubic);
+        TestManager::SetLutData(values_x_cubic, values_y_cubic, std::size(values_x_cubic));
+        TestManager::UpdateModesConstants();
+
+        FP_LONG prev = 0;
+        for (int i = 0; i < BASIC_TEST_STEPS; i++) {
+            float value = range_min + static_cast<float>(i) * (range_max - range_min) / BASIC_TEST_STEPS;
+            auto res = TestManager::AccelLUT(value);
+
+            supervisor.result &= IsAccelValueGood(res);
+            // The grid is linear between its samples of the cubic, which shows where the curve bends the most
+            supervisor.result &= IsCloseEnoughRelative(res, TestManager::EvalFloatFunc(value), 0.0005f);
+            // Allow for the rounding of the grid
+            supervisor.result &= i == 0 || res >= prev - (FP_LONG) 16;
+            prev = res;
+        }
+        for (float value : {3.f, 4.f}) // Inside the flat part
+            supervisor.result &= IsCloseEnoughRelative(TestManager::AccelLUT(value), values_y_cubic[1]);
+
+        TestManager::SetLutInterpolation(LutInterp_Linear);
+
+        supervisor.NextTest();
+
         float values_x2[] = {1, 20, 20, 40, 40};
         float values_y2[] = {1, 1, 2, 2, 3};
         TestManager::SetAccelMode(AccelMode_Lut);
@@ -721,6 +801,210 @@ bool Tests::TestAccelLUT(float range_min, float range_max) {
     return supervisor.GetResult();
 }
 
+bool Tests::TestCurveTable(float range_min, float range_max) {
+    TestSupervisor supervisor{"Compiled Curve"};
+
+    // The batch (what the GUI plots) has to be the exact same curve
+    auto test_batch = [&]() {
+        std::vector<FP_LONG> speeds(BASIC_TEST_STEPS), out(BASIC_TEST_STEPS);
+        for (int i = 0; i < BASIC_TEST_STEPS; i++)
+            speeds[i] = FP64_FromFloat(range_min + static_cast<float>(i + 1) * (range_max - range_min) / BASIC_TEST_STEPS);
+
+        TestManager::AccelBatch(speeds.data(), out.data(), speeds.size());
+        for (int i = 0; i < BASIC_TEST_STEPS; i++)
+            supervisor.result &= out[i] == TestManager::AccelCompiled(FP64_ToFloat(speeds[i]));
+    };
+
+    // Compiled curve against direct evaluation of the same mode, both the measured and the reported error
+    auto test_compiled = [&]() {
+        TestManager::SetUseCurveTable(true);
+        TestManager::UpdateModesConstants();
+
+        const curve_table& curve = TestManager::GetCurveTable();
+        if (!curve.valid) {
+            fprintf(stderr, "Curve table wasn't compiled\n");
+            supervisor.result = false;
+            return;
+        }
+
+        supervisor.result &= FP64_ToFloat(curve.max_error) < CURVE_TABLE_TEST_TOLERANCE;
+
+        for (int i = 1; i <= BASIC_TEST_STEPS; i++) {
+            float value = range_min + static_cast<float>(i) * (range_max - range_min) / BASIC_TEST_STEPS;
+            auto res = TestManager::AccelCompiled(value);
+
+            supervisor.result &= IsAccelValueGood(res);
+            supervisor.result &= IsCloseEnoughRelative(res, FP64_ToFloat(TestManager::AccelDirect(value)), CURVE_TABLE_TEST_TOLERANCE);
+        }
+
+        test_batch();
+    };
+
+    try {
+        supervisor.NextTest();
+
+        TestManager::SetAccelMode(AccelMode_Power);
+        TestManager::SetAcceleration(5.0f);
+        TestManager::SetExponent(0.01f);
+        TestManager::SetMidpoint(1.0f);
+        test_compiled();
+
+        supervisor.NextTest();
+
+        TestManager::SetAccelMode(AccelMode_Classic);
+        TestManager::SetAcceleration(0.1f);
+        TestManager::SetExponent(3.f);
+        TestManager::SetMidpoint(5.f);
+        TestManager::SetUseSmoothing(true);
+        test_compiled();
+
+        supervisor.NextTest();
+
+        TestManager::SetAccelMode(AccelMode_Motivity);
+        TestManager::SetAcceleration(4.f);
+        TestManager::SetMidpoint(10.f);
+        test_compiled();
+
+        supervisor.NextTest();
+
+        TestManager::SetAccelMode(AccelMode_Synchronous);
+        TestManager::SetExponent(2.f);
+        TestManager::SetMidpoint(0.5f);
+        TestManager::SetMotivity(1.75f);
+        TestManager::SetAcceleration(5.f);
+        TestManager::SetUseSmoothing(true);
+        test_compiled();
+
+        supervisor.NextTest();
+
+        TestManager::SetAccelMode(AccelMode_Natural);
+        TestManager::SetAcceleration(0.1f);
+        TestManager::SetExponent(2.f);
+        TestManager::SetMidpoint(2.f);
+        TestManager::SetUseSmoothing(true);
+        test_compiled();
+
+        supervisor.NextTest();
+
+        TestManager::SetAccelMode(AccelMode_Jump);
+        TestManager::SetAcceleration(4.f);
+        TestManager::SetMidpoint(10.f);
+        TestManager::SetExponent(0.2f); // Smoothness
+        TestManager::SetUseSmoothing(true);
+        test_compiled();
+
+        supervisor.NextTest();
+
+        // Direct evaluation when the table is turned off
+        TestManager::SetUseCurveTable(false);
+        TestManager::UpdateModesConstants();
+
+        supervisor.result &= !TestManager::GetCurveTable().valid;
+
+        for (int i = 1; i <= BASIC_TEST_STEPS; i++) {
+            float value = range_min + static_cast<float>(i) * (range_max - range_min) / BASIC_TEST_STEPS;
+            supervisor.result &= TestManager::AccelCompiled(value) == TestManager::AccelDirect(value);
+        }
+        test_batch();
+    }
+    catch (std::exception &ex) {
+        fprintf(stderr, "Exception: %s, in the compiled curve\n", ex.what());
+        supervisor.result = false;
+    }
+
+    TestManager::SetUseCurveTable(false);
+
+    return supervisor.GetResult();
+}
+
+bool Tests::TestAngleSnapping() {
+    TestSupervisor supervisor{"Angle Snapping"};
+
+    // The snapping as it used to be done in the driver, through the angle itself. The difference is wrapped into (-PI, PI],
+    // the driver didn't do that and missed the snapping direction across the +-PI boundary.
+    auto reference_snap = [](FP_LONG& x, FP_LONG& y, FP_LONG mag, FP_LONG angle, FP_LONG half_threshold) {
+        FP_LONG angle_diff = FP64_Sub(angle, FP64_Atan2(y, x));
+        if (angle_diff > FP64_PI)
+            angle_diff -= 2 * FP64_PI;
+        FP_LONG angle_diff_quarter = FP64_PI_2 - FP64_Abs(angle_diff);
+
+        int sign = FP64_Sign(angle_diff_quarter);
+        angle_diff_quarter = FP64_Abs(angle_diff_quarter) - FP64_PI_2;
+
+        if (FP64_Abs(angle_diff_quarter) <= half_threshold) {
+            x = FP64_Mul(FP64_Cos(angle), mag) * sign;
+            y = FP64_Mul(FP64_Sin(angle), mag) * sign;
+        }
+    };
+
+    // Sensitivity, snapping and rotation one after the other, against the driver's single pass
+    auto test_snapping = [&](float angle, float threshold, float sens, float sensY, float rotation) {
+        TestManager::SetAngleSnap_Angle(angle);
+        TestManager::SetAngleSnap_Threshold(threshold);
+        TestManager::SetSensitivity(sens, sensY);
+        TestManager::SetRotationAngle(rotation);
+        TestManager::UpdateModesConstants();
+
+        for (float mag : {1.f, 7.5f, 120.f}) {
+            for (int i = 0; i < ANGLE_SNAP_TEST_STEPS; i++) {
+                float motion_angle = static_cast<float>(i) * 2 * M_PI / ANGLE_SNAP_TEST_STEPS;
+                float motion_x = mag * std::cos(motion_angle), motion_y = mag * std::sin(motion_angle);
+
+                // Too close to the edge of the snapping zone to tell the two apart
+                float scaled_angle = std::atan2(motion_y * sensY, motion_x * sens);
+                float diff = std::fmod(std::abs(scaled_angle - angle), M_PI);
+                if (std::abs(std::min(diff, static_cast<float>(M_PI) - diff) - threshold / 2) < 1e-3f)
+                    continue;
+
+                FP_LONG x = FP64_FromFloat(motion_x), y = FP64_FromFloat(motion_y);
+                FP_LONG ref_x = FP64_Mul(x, FP64_FromFloat(sens)), ref_y = FP64_Mul(y, FP64_FromFloat(sensY));
+                FP_LONG ref_mag = FP64_Sqrt(FP64_Add(FP64_Mul(ref_x, ref_x), FP64_Mul(ref_y, ref_y)));
+
+                TestManager::AccelOutput(x, y);
+
+                reference_snap(ref_x, ref_y, ref_mag, FP64_FromFloat(angle), FP64_FromFloat(threshold / 2));
+                FP_LONG rot_x = FP64_Sub(FP64_Mul(ref_x, FP64_FromFloat(std::cos(rotation))), FP64_Mul(ref_y, FP64_FromFloat(std::sin(rotation))));
+                ref_y = FP64_Add(FP64_Mul(ref_x, FP64_FromFloat(std::sin(rotation))), FP64_Mul(ref_y, FP64_FromFloat(std::cos(rotation))));
+                ref_x = rot_x;
+
+                supervisor.result &= IsCloseEnough(x, FP64_ToFloat(ref_x), 1e-3f * mag);
+                supervisor.result &= IsCloseEnough(y, FP64_ToFloat(ref_y), 1e-3f * mag);
+            }
+        }
+    };
+
+    try {
+        for (float angle : {0.f, 0.5f, 1.5708f, 2.5f, 3.14f}) {
+            supervisor.NextTest();
+
+            for (float threshold : {0.01f, 0.3f, 1.f, 1.5708f, 3.f})
+                test_snapping(angle, threshold, 1.f, 1.f, 0.f);
+        }
+
+        supervisor.NextTest();
+
+        // Through the transform
+        for (float threshold : {0.f, 0.3f, 1.5708f}) {
+            test_snapping(0.5f, threshold, 1.5f, 1.5f, 0.f);
+            test_snapping(0.5f, threshold, 1.5f, 0.7f, 0.f);
+            test_snapping(2.5f, threshold, 0.4f, 2.f, 0.3f);
+            test_snapping(0.f, threshold, 1.f, 1.f, -1.f);
+        }
+    }
+    catch (std::exception &ex) {
+        fprintf(stderr, "Exception: %s, in angle snapping\n", ex.what());
+        supervisor.result = false;
+    }
+
+    TestManager::SetSensitivity(1.f, 1.f);
+    TestManager::SetRotationAngle(0.f);
+    TestManager::SetAngleSnap_Angle(0.f);
+    TestManager::SetAngleSnap_Threshold(0.f);
+    TestManager::UpdateModesConstants();
+
+    return supervisor.GetResult();
+}
+
 bool Tests::TestAccelMode(AccelMode mode, float range_min, float range_max) {
     static_assert(AccelMode_Count == 10);
 
@@ -801,6 +1085,24 @@ bool Tests::TestFixedPointArithmetic() {
                 //printf("(%f, %i), %f,%f,%f\n", x1, x2, FP64_ToFloat(val), std::scalbln(x1, x2), FP64_ToFloat(val) - std::scalbln(x1, x2));
             }
         }
+
+        supervisor.NextTest();
+
+        // Division without the hardware divide, ~23.7 bits relative (or the resolution of Q32.32 for tiny quotients)
+        for (int i = 0; i < BASIC_TEST_STEPS_REDUCED; i++) {
+            double a = -1000 + static_cast<double>(i) * 2000 / BASIC_TEST_STEPS_REDUCED;
+            for (int j = 1; j <= BASIC_TEST_STEPS_REDUCED; j++) {
+                double b = std::pow(10.0, -3 + 6.0 * j / BASIC_TEST_STEPS_REDUCED) * ((j % 2) ? 1 : -1);
+                if (std::abs(a / b) > 1e9)
+                    continue;
+
+                FP_LONG fa = FP64_FromDouble(a), fb = FP64_FromDouble(b);
+                double exact = static_cast<double>(fa) / static_cast<double>(fb);
+                double val = static_cast<double>(FP64_DivNewton(fa, fb)) / 4294967296.0;
+
+                supervisor.result &= std::abs(val - exact) <= std::max(std::abs(exact) * 1e-7, 1e-9);
+            }
+        }
     }
     catch (std::exception &ex) {
         fprintf(stderr, "Exception: %s during arithmetic\n", ex.what());
@@ -810,6 +1112,52 @@ bool Tests::TestFixedPointArithmetic() {
     return supervisor.GetResult();
 }
 
+bool Tests::TestLutText() {
+    TestSupervisor supervisor{"LUT Text"};
+
+    try {
+        // Six decimals, like the driver prints them, so every step of the way is exact
+        static double values_x[MAX_LUT_ARRAY_SIZE], values_y[MAX_LUT_ARRAY_SIZE];
+        for (int i = 0; i < MAX_LUT_ARRAY_SIZE; i++) {
+            values_x[i] = std::round((0.05 + i * 0.0375) * 1e6) / 1e6;
+            values_y[i] = std::round((1 + 0.5 * std::sin(i * 0.01)) * 1e6) / 1e6;
+        }
+
+        supervisor.NextTest();
+
+        // What LutDataBuf reads as, all of it at once
+        std::filesystem::create_directories(YEETMOUSE_PARAMS_DIR);
+        {
+            std::ofstream file(YEETMOUSE_PARAMS_DIR "LutDataBuf");
+            for (int i = 0; i < MAX_LUT_ARRAY_SIZE; i++)
+                file << std::to_string(values_x[i]) << ';' << std::to_string(values_y[i]) << ';';
+            file << '\n';
+        }
+
+        static double read_x[MAX_LUT_ARRAY_SIZE], read_y[MAX_LUT_ARRAY_SIZE];
+        size_t size = DriverHelper::ReadLutData(read_x, read_y, MAX_LUT_ARRAY_SIZE);
+        supervisor.result &= size == MAX_LUT_ARRAY_SIZE;
+        for (size_t i = 0; i < size; i++)
+            supervisor.result &= read_x[i] == values_x[i] && read_y[i] == values_y[i];
+
+        supervisor.NextTest();
+
+        // Through the text box, the way the GUI fills it on start and parses it on "Save"
+        std::string text = DriverHelper::EncodeLutData(read_x, read_y, size);
+        static double parsed_x[MAX_LUT_ARRAY_SIZE], parsed_y[MAX_LUT_ARRAY_SIZE];
+        size_t parsed = DriverHelper::ParseUserLutData(text, parsed_x, parsed_y, MAX_LUT_ARRAY_SIZE);
+        supervisor.result &= parsed == MAX_LUT_ARRAY_SIZE;
+        for (size_t i = 0; i < parsed; i++)
+            supervisor.result &= parsed_x[i] == values_x[i] && parsed_y[i] == values_y[i];
+    }
+    catch (std::exception &ex) {
+        fprintf(stderr, "Exception: %s during the LUT text\n", ex.what());
+        supervisor.result = false;
+    }
+
+    return supervisor.GetResult();
+}
+
 void Tests::TestSupervisor::NextTest() {
     if (test_idx > 1) {
         printf("Test #%d: %s\n" RESET, test_idx - 1, result ? GREEN "Passed" : RED "Failed");
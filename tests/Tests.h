@@ -2,6 +2,7 @@
 #define TESTS_H
 
 
+#include <array>
 #include <vector>
 #include "../shared_definitions.h"
 #include "driver/config.h"
@@ -10,6 +11,8 @@
 #define BASIC_TEST_STEPS 1000
 #define BASIC_TEST_STEPS_REDUCED 100
 #define BASIC_TEST_RANGE_MAX 150
+#define CURVE_TABLE_TEST_TOLERANCE 0.001f
+#define ANGLE_SNAP_TEST_STEPS 3600
 
 #define RESET   "\033[0m"
 #define RED     "\033[31m" // Red
@@ -39,11 +42,17 @@ public:
     static bool TestAccelJump(float range_min = 0, float range_max = BASIC_TEST_RANGE_MAX);
     static bool TestAccelLUT(float range_min = 0, float range_max = BASIC_TEST_RANGE_MAX);
 
+    static bool TestCurveTable(float range_min = 0, float range_max = BASIC_TEST_RANGE_MAX);
+    static bool TestAngleSnapping();
+
     static bool TestAccelMode(AccelMode mode, float range_min = 0, float range_max = BASIC_TEST_RANGE_MAX);
 
     static std::array<bool, AccelMode_Count> TestAllBasic(float range_min = 0, float range_max = BASIC_TEST_RANGE_MAX);
     static bool TestFixedPointArithmetic();
 
+    // A full LUT read back from the driver, put into the GUI's text box and parsed again
+    static bool TestLutText();
+
 private:
     //static CachedFunction functions[AccelMode_Count];
 
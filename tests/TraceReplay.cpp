@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#define private private_ // input_handle has a member named 'private'
+#include <linux/usb/input.h>
+#undef private
+#include <linux/moduleparam.h>
+
+extern struct input_handler driver_handler;
+int kshim_module_init(void);
+void kshim_module_exit(void);
+}
+
+///
+/// Streams a recorded motion trace through the driver's input handler (driver_events()) in userspace
+/// and reports the throughput, the latency percentiles, a checksum of the output and the driver's health counters
+///
+/// Usage: TraceReplay [-p Name=Value]... [-b frames per batch] [-i iterations] [trace]
+///     -p - sets a module parameter before the replay, like writing to /sys/module/yeetmouse/parameters/Name.
+///          The parameters are committed with update=1 once all of them are set
+///     -b - how many SYN_REPORT frames the input core delivers at once (IRQ coalescing), 1 by default
+///     -i - how many times the whole trace is replayed, 10 by default
+///     trace - raw dump of struct input_event (e.g. `cat /dev/input/eventN > trace.bin`), '-' (default)
+///             for a synthetic 8 kHz trace
+///
+
+// Layout of struct input_event on 64-bit
+struct RecordedEvent {
+    int64_t sec;
+    int64_t usec;
+    uint16_t type;
+    uint16_t code;
+    int32_t value;
+};
+
+struct Frame {
+    ktime_t timestamp;
+    std::vector<input_value> values;
+};
+
+struct Batch {
+    ktime_t timestamp;
+    std::vector<input_value> values;
+};
+
+static bool LoadTrace(const char* path, std::vector<Frame>& frames) {
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return false;
+
+    RecordedEvent event{};
+    Frame frame{};
+    while (fread(&event, sizeof(event), 1, file) == 1) {
+        frame.values.push_back({event.type, event.code, event.value});
+        if (event.type == EV_SYN && event.code == SYN_REPORT) {
+            frame.timestamp = event.sec * NSEC_PER_SEC + event.usec * NSEC_PER_USEC;
+            frames.push_back(frame);
+            frame.values.clear();
+        }
+    }
+
+    fclose(file);
+    return !frames.empty();
+}
+
+// 10 seconds of an 8 kHz mouse drawing circles at a varying speed, with device timestamps
+static void SynthesizeTrace(std::vector<Frame>& frames) {
+    const int rate = 8000;
+    const ktime_t period = NSEC_PER_SEC / rate;
+
+    for (int i = 0; i < rate * 10; i++) {
+        double t = static_cast<double>(i) / rate;
+        double speed = 1 + 20 * (0.5 + 0.5 * std::sin(t * 0.7));
+        int x = static_cast<int>(std::lround(speed * std::cos(t * 3)));
+        int y = static_cast<int>(std::lround(speed * std::sin(t * 3)));
+
+        Frame frame{};
+        frame.timestamp = (i + 1) * period;
+        frame.values.push_back({EV_MSC, MSC_TIMESTAMP, static_cast<s32>(frame.timestamp / NSEC_PER_USEC)});
+        if (x != 0)
+            frame.values.push_back({EV_REL, REL_X, x});
+        if (y != 0)
+            frame.values.push_back({EV_REL, REL_Y, y});
+        frame.values.push_back({EV_SYN, SYN_REPORT, 0});
+        frames.push_back(frame);
+    }
+}
+
+// FNV-1a, over everything the handler passes on, in order
+static uint64_t HashValues(uint64_t hash, const input_value* values, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+        const uint32_t words[3] = {values[i].type, values[i].code, static_cast<uint32_t>(values[i].value)};
+        for (uint32_t word : words) {
+            for (int b = 0; b < 4; b++) {
+                hash ^= (word >> (b * 8)) & 0xFF;
+                hash *= 0x100000001B3ull;
+            }
+        }
+    }
+    return hash;
+}
+
+static double Percentile(const std::vector<double>& sorted, double p) {
+    size_t index = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, index > 0 ? index - 1 : 0)];
+}
+
+static int Usage(const char* name) {
+    fprintf(stderr, "Usage: %s [-p Name=Value]... [-b frames per batch] [-i iterations] [trace]\n", name);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> params;
+    int frames_per_batch = 1;
+    int iterations = 10;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:b:i:")) != -1) {
+        switch (opt) {
+            case 'p':
+                params.emplace_back(optarg);
+                break;
+            case 'b':
+                frames_per_batch = std::atoi(optarg);
+                break;
+            case 'i':
+                iterations = std::atoi(optarg);
+                break;
+            default:
+                return Usage(argv[0]);
+        }
+    }
+    const char* trace = optind < argc ? argv[optind] : "-";
+
+    if (frames_per_batch < 1 || iterations < 1 || optind + 1 < argc)
+        return Usage(argv[0]);
+
+    std::vector<Frame> frames;
+    if (strcmp(trace, "-") == 0)
+        SynthesizeTrace(frames);
+    else if (!LoadTrace(trace, frames)) {
+        fprintf(stderr, "Couldn't load any frames from '%s'\n", trace);
+        return 1;
+    }
+
+    // The input core hands out the timestamp of the latest frame for the whole batch
+    std::vector<Batch> batches;
+    size_t max_batch_len = 0;
+    for (size_t i = 0; i < frames.size(); i += frames_per_batch) {
+        Batch batch{};
+        for (size_t j = i; j < frames.size() && j < i + frames_per_batch; j++) {
+            batch.values.insert(batch.values.end(), frames[j].values.begin(), frames[j].values.end());
+            batch.timestamp = frames[j].timestamp;
+        }
+        max_batch_len = std::max(max_batch_len, batch.values.size());
+        batches.push_back(batch);
+    }
+
+    if (kshim_module_init() != 0) {
+        fprintf(stderr, "Module init failed\n");
+        return 1;
+    }
+
+    if (!params.empty()) {
+        for (std::string& param : params) {
+            size_t eq = param.find('=');
+            if (eq == std::string::npos) {
+                fprintf(stderr, "Expected Name=Value, got '%s'\n", param.c_str());
+                return 1;
+            }
+            std::string name = param.substr(0, eq);
+            if (kshim_param_set(name.c_str(), param.c_str() + eq + 1) != 0) {
+                fprintf(stderr, "Couldn't set '%s'\n", param.c_str());
+                return 1;
+            }
+        }
+        if (kshim_param_set("update", "1") != 0) {
+            fprintf(stderr, "Couldn't commit the parameters\n");
+            return 1;
+        }
+    }
+
+    input_dev dev{};
+    dev.name = "TraceReplay mouse";
+    if (driver_handler.connect(&driver_handler, &dev, nullptr) != 0 || !dev.kshim_handle) {
+        fprintf(stderr, "Couldn't connect to the fake device\n");
+        return 1;
+    }
+    input_handle* handle = dev.kshim_handle;
+    printf("\n"); // printk() adds the newline in the kernel
+
+    std::vector<input_value> work(max_batch_len);
+    const ktime_t trace_length = frames.back().timestamp - frames.front().timestamp + NSEC_PER_MSEC;
+    std::vector<double> event_ns; // Time per input value of every call, a batch counts as that many samples
+    event_ns.reserve(frames.size() * iterations * 4);
+    double total_ns = 0, best_iteration_ns = 1e18;
+    size_t values_in = 0, values_out = 0;
+    uint64_t checksum = 0xCBF29CE484222325ull;
+    long long sum_x = 0, sum_y = 0;
+
+    for (int iter = 0; iter < iterations; iter++) {
+        double iteration_ns = 0;
+        for (const Batch& batch : batches) {
+            std::copy(batch.values.begin(), batch.values.end(), work.begin());
+            dev.timestamp[INPUT_CLK_MONO] = batch.timestamp + iter * trace_length;
+
+            auto start = std::chrono::steady_clock::now();
+            unsigned int count = handle->handler->events(handle, work.data(), batch.values.size());
+            auto end = std::chrono::steady_clock::now();
+
+            double ns = std::chrono::duration<double, std::nano>(end - start).count();
+            iteration_ns += ns;
+            event_ns.insert(event_ns.end(), batch.values.size(), ns / batch.values.size());
+
+            values_in += batch.values.size();
+            values_out += count;
+            checksum = HashValues(checksum, work.data(), count);
+            for (unsigned int i = 0; i < count; i++) {
+                if (work[i].type != EV_REL)
+                    continue;
+                if (work[i].code == REL_X)
+                    sum_x += work[i].value;
+                else if (work[i].code == REL_Y)
+                    sum_y += work[i].value;
+            }
+        }
+        total_ns += iteration_ns;
+        best_iteration_ns = std::min(best_iteration_ns, iteration_ns);
+    }
+
+    std::sort(event_ns.begin(), event_ns.end());
+
+    printf("Frames: %zu, batches: %zu (%d frames per batch), iterations: %d\n", frames.size(), batches.size(),
+           frames_per_batch, iterations);
+    printf("Throughput: %.2f M events/s (best iteration %.2f M events/s)\n", values_in / total_ns * 1e3,
+           values_in / iterations / best_iteration_ns * 1e3);
+    printf("ns per event: p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n", Percentile(event_ns, 50),
+           Percentile(event_ns, 90), Percentile(event_ns, 99), Percentile(event_ns, 99.9), event_ns.back());
+    printf("ns per frame: avg %.1f, best iteration %.1f\n", total_ns / (frames.size() * iterations),
+           best_iteration_ns / frames.size());
+    printf("Events in: %zu, passed on: %zu\n", values_in, values_out);
+    printf("Output sum: x %lld, y %lld\n", sum_x, sum_y);
+    printf("Checksum: %016llx\n", static_cast<unsigned long long>(checksum));
+
+    // Where the replay ran outside of the profile's intended range
+    char health[4096];
+    if (kshim_param_get("Health", health) > 0)
+        printf("\nHealth (all iterations):\n%s", health);
+
+    driver_handler.disconnect(handle);
+    kshim_module_exit();
+
+    return 0;
+}
@@ -0,0 +1,2 @@
+// The driver's default configuration (driver/config.h is only created by its Makefile)
+#include "../../driver/config.sample.h"
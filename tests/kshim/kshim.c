@@ -0,0 +1,86 @@
+// Userspace implementations of the few kernel functions the driver calls
+
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
+#include <time.h>
+
+ktime_t ktime_get(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ktime_t) ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+int param_set_byte(const char *val, const struct kernel_param *kp) {
+    char *end;
+    unsigned long res = strtoul(val, &end, 0);
+    if (end == val || res > 0xFF)
+        return -EINVAL;
+    *(unsigned char *) kp->arg = (unsigned char) res;
+    return 0;
+}
+
+int param_get_byte(char *buffer, const struct kernel_param *kp) {
+    return sprintf(buffer, "%hhu\n", *(unsigned char *) kp->arg);
+}
+
+static struct kshim_param *params;
+
+void kshim_param_register(struct kshim_param *param) {
+    param->next = params;
+    params = param;
+}
+
+static struct kshim_param *find_param(const char *name) {
+    struct kshim_param *param;
+    for (param = params; param; param = param->next) {
+        if (strcmp(param->kp.name, name) == 0)
+            return param;
+    }
+    return NULL;
+}
+
+int kshim_param_set(const char *name, const char *val) {
+    struct kshim_param *param = find_param(name);
+    if (!param)
+        return -ENOENT;
+
+    switch (param->type) {
+        case KSHIM_PARAM_byte:
+            return param_set_byte(val, &param->kp);
+        case KSHIM_PARAM_uint:
+            return kstrtouint(val, 0, (unsigned int *) param->kp.arg);
+        case KSHIM_PARAM_charp:
+            // The kernel copies the value too (and never frees the ones set before the module was loaded)
+            *(char **) param->kp.arg = strdup(val);
+            return 0;
+        case KSHIM_PARAM_string:
+            if (strlen(val) + 1 > param->len)
+                return -ENOSPC;
+            strcpy((char *) param->kp.arg, val);
+            return 0;
+        case KSHIM_PARAM_ops:
+            return param->kp.ops->set ? param->kp.ops->set(val, &param->kp) : -EPERM;
+    }
+    return -EINVAL;
+}
+
+int kshim_param_get(const char *name, char *buffer) {
+    struct kshim_param *param = find_param(name);
+    if (!param)
+        return -ENOENT;
+
+    switch (param->type) {
+        case KSHIM_PARAM_byte:
+            return param_get_byte(buffer, &param->kp);
+        case KSHIM_PARAM_uint:
+            return sprintf(buffer, "%u\n", *(unsigned int *) param->kp.arg);
+        case KSHIM_PARAM_charp:
+            return sprintf(buffer, "%s\n", *(char **) param->kp.arg);
+        case KSHIM_PARAM_string:
+            return sprintf(buffer, "%s\n", (char *) param->kp.arg);
+        case KSHIM_PARAM_ops:
+            return param->kp.ops->get ? param->kp.ops->get(buffer, &param->kp) : -EPERM;
+    }
+    return -EINVAL;
+}
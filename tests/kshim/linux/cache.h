@@ -0,0 +1,6 @@
+#ifndef KSHIM_LINUX_CACHE_H
+#define KSHIM_LINUX_CACHE_H
+
+#define ____cacheline_aligned __attribute__((aligned(64)))
+
+#endif
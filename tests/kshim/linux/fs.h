@@ -0,0 +1,29 @@
+#ifndef KSHIM_LINUX_FS_H
+#define KSHIM_LINUX_FS_H
+
+#include <linux/types.h>
+
+#define FMODE_READ 0x1
+#define FMODE_WRITE 0x2
+
+struct inode;
+struct vm_area_struct;
+
+struct file {
+    unsigned int f_mode;
+};
+struct file_operations {
+    void *owner;
+    int (*open)(struct inode *, struct file *);
+    int (*release)(struct inode *, struct file *);
+    int (*mmap)(struct file *, struct vm_area_struct *);
+    long (*unlocked_ioctl)(struct file *, unsigned int, unsigned long);
+    long (*compat_ioctl)(struct file *, unsigned int, unsigned long);
+    long long (*llseek)(struct file *, long long, int);
+};
+
+#define compat_ptr_ioctl NULL // Like the kernel without CONFIG_COMPAT
+
+static inline long long noop_llseek(struct file *file, long long offset, int whence) { return 0; }
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef KSHIM_LINUX_HID_H
+#define KSHIM_LINUX_HID_H
+
+#include <linux/usb/input.h>
+
+struct hid_device {
+    struct device dev;
+    const char *name;
+};
+
+#define to_hid_device(pdev) ((struct hid_device *) (pdev))
+
+#endif
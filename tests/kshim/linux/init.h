@@ -0,0 +1,7 @@
+#ifndef KSHIM_LINUX_INIT_H
+#define KSHIM_LINUX_INIT_H
+
+#define __init
+#define __exit
+
+#endif
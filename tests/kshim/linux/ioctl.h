@@ -0,0 +1,6 @@
+#ifndef KSHIM_LINUX_IOCTL_H
+#define KSHIM_LINUX_IOCTL_H
+
+#include <asm/ioctl.h> // _IO() and friends, the same as in the kernel
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef KSHIM_LINUX_JUMP_LABEL_H
+#define KSHIM_LINUX_JUMP_LABEL_H
+
+#include <linux/types.h>
+
+// No code patching in userspace, a key is a plain counter (on while positive, like static_branch_inc/dec)
+struct static_key_false { int enabled; };
+struct static_key_true { int enabled; };
+
+#define DEFINE_STATIC_KEY_FALSE(name) struct static_key_false name = { 0 }
+#define DECLARE_STATIC_KEY_FALSE(name) extern struct static_key_false name
+#define DEFINE_STATIC_KEY_TRUE(name) struct static_key_true name = { 1 }
+
+#define static_branch_likely(key) __builtin_expect((key)->enabled > 0, 1)
+#define static_branch_unlikely(key) __builtin_expect((key)->enabled > 0, 0)
+#define static_branch_enable(key) ((key)->enabled = true)
+#define static_branch_disable(key) ((key)->enabled = false)
+#define static_branch_inc(key) ((key)->enabled++)
+#define static_branch_dec(key) ((key)->enabled--)
+
+#endif
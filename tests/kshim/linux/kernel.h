@@ -0,0 +1,47 @@
+#ifndef KSHIM_LINUX_KERNEL_H
+#define KSHIM_LINUX_KERNEL_H
+
+#include <linux/types.h>
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define printk printf
+#define pr_info printf
+#define pr_warn printf
+#define pr_err printf
+#define pr_fmt(fmt) fmt
+
+static inline int kstrtouint(const char *s, unsigned int base, unsigned int *res) {
+    char *end;
+    unsigned long val = strtoul(s, &end, base);
+    if (end == s || (*end != '\0' && *end != '\n') || val > UINT_MAX)
+        return -EINVAL;
+    *res = (unsigned int) val;
+    return 0;
+}
+
+#define __maybe_unused __attribute__((unused))
+
+#define likely(x) __builtin_expect(!!(x), 1)
+#define unlikely(x) __builtin_expect(!!(x), 0)
+
+#define READ_ONCE(x) (*(volatile __typeof__(x) *) &(x))
+#define WRITE_ONCE(x, v) (*(volatile __typeof__(x) *) &(x) = (v))
+
+#define PAGE_SIZE 4096UL
+
+#define scnprintf(buf, size, ...) ({ int _len = snprintf(buf, size, __VA_ARGS__); \
+                                     _len < (int) (size) ? _len : (int) (size) - 1; })
+
+#define BUILD_BUG_ON(cond) _Static_assert(!(cond), #cond)
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+#define NSEC_PER_USEC 1000L
+#define NSEC_PER_MSEC 1000000L
+#define NSEC_PER_SEC 1000000000L
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef KSHIM_LINUX_KTIME_H
+#define KSHIM_LINUX_KTIME_H
+
+#include <linux/types.h>
+
+ktime_t ktime_get(void);
+
+static inline s64 ktime_to_ns(ktime_t kt) {
+    return kt;
+}
+
+static inline ktime_t ktime_sub(ktime_t lhs, ktime_t rhs) {
+    return lhs - rhs;
+}
+
+static inline ktime_t ktime_add_us(ktime_t kt, u64 usec) {
+    return kt + (ktime_t) usec * 1000;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef KSHIM_LINUX_MISCDEVICE_H
+#define KSHIM_LINUX_MISCDEVICE_H
+
+#include <linux/fs.h>
+
+// There are no device nodes in userspace, registering always succeeds and nothing can open the device
+#define MISC_DYNAMIC_MINOR 255
+
+struct miscdevice {
+    int minor;
+    const char *name;
+    const struct file_operations *fops;
+    unsigned short mode;
+};
+
+static inline int misc_register(struct miscdevice *misc) { return 0; }
+static inline void misc_deregister(struct miscdevice *misc) { }
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef KSHIM_LINUX_MM_H
+#define KSHIM_LINUX_MM_H
+
+#include <linux/slab.h>
+
+#define VM_WRITE 0x00000002
+#define VM_MAYWRITE 0x00000020
+
+struct vm_area_struct {
+    unsigned long vm_flags;
+    unsigned long vm_pgoff;
+};
+
+static inline void vm_flags_clear(struct vm_area_struct *vma, unsigned long flags) { vma->vm_flags &= ~flags; }
+static inline int remap_vmalloc_range(struct vm_area_struct *vma, void *addr, unsigned long pgoff) { return -EINVAL; }
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef KSHIM_LINUX_MODULE_H
+#define KSHIM_LINUX_MODULE_H
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/moduleparam.h>
+
+#define MODULE_AUTHOR(author)
+#define MODULE_DESCRIPTION(desc)
+#define MODULE_LICENSE(license)
+#define MODULE_DEVICE_TABLE(type, name)
+#define THIS_MODULE NULL
+
+// The module's init/exit functions are reachable through these
+#define module_init(fn) int kshim_module_init(void) { return fn(); }
+#define module_exit(fn) void kshim_module_exit(void) { fn(); }
+
+int kshim_module_init(void);
+void kshim_module_exit(void);
+
+#endif
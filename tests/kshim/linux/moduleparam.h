@@ -0,0 +1,63 @@
+#ifndef KSHIM_LINUX_MODULEPARAM_H
+#define KSHIM_LINUX_MODULEPARAM_H
+
+#include <linux/kernel.h>
+
+struct kernel_param;
+
+struct kernel_param_ops {
+    unsigned int flags;
+    int (*set)(const char *val, const struct kernel_param *kp);
+    int (*get)(char *buffer, const struct kernel_param *kp);
+    void (*free)(void *arg);
+};
+
+struct kernel_param {
+    const char *name;
+    const struct kernel_param_ops *ops;
+    void *arg;
+};
+
+// There is no sysfs, the parameters register themselves on startup instead and are
+// read and written by name with kshim_param_get() and kshim_param_set()
+enum kshim_param_type {
+    KSHIM_PARAM_byte,
+    KSHIM_PARAM_uint,
+    KSHIM_PARAM_charp,
+    KSHIM_PARAM_string,
+    KSHIM_PARAM_ops,
+};
+
+struct kshim_param {
+    struct kernel_param kp;
+    enum kshim_param_type type;
+    size_t len; // Buffer size for KSHIM_PARAM_string
+    struct kshim_param *next;
+};
+
+void kshim_param_register(struct kshim_param *param);
+// Same as a write to /sys/module/.../parameters/<name>, returns 0 or a negative errno
+int kshim_param_set(const char *name, const char *val);
+// Same as a read, buffer has to hold at least 4096 bytes. Returns the length or a negative errno
+int kshim_param_get(const char *name, char *buffer);
+
+#define KSHIM_PARAM(name, type, arg, len, ops)                                                              \
+    static struct kshim_param kshim_param_##name = {{#name, ops, (void *) (arg)}, type, len, NULL};         \
+    __attribute__((constructor)) static void kshim_param_register_##name(void) {                            \
+        kshim_param_register(&kshim_param_##name);                                                          \
+    }
+
+#define MODULE_PARM_DESC(name, desc)
+#define module_param_named(name, value, type, perm) KSHIM_PARAM(name, KSHIM_PARAM_##type, &(value), 0, NULL)
+#define module_param(name, type, perm) module_param_named(name, name, type, perm)
+#define module_param_string(name, string, len, perm) KSHIM_PARAM(name, KSHIM_PARAM_string, string, len, NULL)
+#define module_param_cb(name, ops, arg, perm) KSHIM_PARAM(name, KSHIM_PARAM_ops, arg, 0, ops)
+
+// Writes through kshim_param_set() aren't serialized, there's only the one thread
+#define kernel_param_lock(mod) do { } while (0)
+#define kernel_param_unlock(mod) do { } while (0)
+
+int param_set_byte(const char *val, const struct kernel_param *kp);
+int param_get_byte(char *buffer, const struct kernel_param *kp);
+
+#endif
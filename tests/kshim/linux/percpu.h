@@ -0,0 +1,15 @@
+#ifndef KSHIM_LINUX_PERCPU_H
+#define KSHIM_LINUX_PERCPU_H
+
+#include <linux/kernel.h>
+
+// A single CPU, a per-CPU variable is just a variable
+#define DEFINE_PER_CPU(type, name) __typeof__(type) name
+#define DECLARE_PER_CPU(type, name) extern __typeof__(type) name
+
+#define for_each_possible_cpu(cpu) for ((cpu) = 0; (cpu) < 1; (cpu)++)
+#define per_cpu(var, cpu) (*((void) (cpu), &(var)))
+#define per_cpu_ptr(ptr, cpu) ((void) (cpu), (ptr))
+#define this_cpu_inc(var) ((var)++)
+
+#endif
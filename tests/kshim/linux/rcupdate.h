@@ -0,0 +1,15 @@
+#ifndef KSHIM_LINUX_RCUPDATE_H
+#define KSHIM_LINUX_RCUPDATE_H
+
+// Single threaded, so there are never any readers to wait for
+#define __rcu
+#define rcu_read_lock() do { } while (0)
+#define rcu_read_unlock() do { } while (0)
+#define rcu_dereference(p) (p)
+#define rcu_dereference_protected(p, c) (p)
+#define rcu_assign_pointer(p, v) ((p) = (v))
+#define RCU_INIT_POINTER(p, v) ((p) = (v))
+
+static inline void synchronize_rcu(void) { }
+
+#endif
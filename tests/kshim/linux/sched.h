@@ -0,0 +1,6 @@
+#ifndef KSHIM_LINUX_SCHED_H
+#define KSHIM_LINUX_SCHED_H
+
+#define cond_resched() do { } while (0)
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef KSHIM_LINUX_SLAB_H
+#define KSHIM_LINUX_SLAB_H
+
+#include <linux/kernel.h>
+
+#define GFP_KERNEL 0
+
+static inline void *kzalloc(size_t size, int flags) { (void) flags; return calloc(1, size); }
+static inline void *kmalloc(size_t size, int flags) { (void) flags; return malloc(size); }
+static inline void kfree(const void *p) { free((void *) p); }
+static inline void *kvzalloc(size_t size, int flags) { return kzalloc(size, flags); }
+static inline void *kvmalloc(size_t size, int flags) { return kmalloc(size, flags); }
+static inline void kvfree(const void *p) { kfree(p); }
+
+#endif
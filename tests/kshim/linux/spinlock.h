@@ -0,0 +1,14 @@
+#ifndef KSHIM_LINUX_SPINLOCK_H
+#define KSHIM_LINUX_SPINLOCK_H
+
+// Single threaded, so locking is a no-op
+typedef struct { int unused; } spinlock_t;
+
+#define DEFINE_SPINLOCK(name) spinlock_t name = { 0 }
+#define spin_lock_irqsave(lock, flags) ((void) (lock), (flags) = 0)
+#define spin_unlock_irqrestore(lock, flags) ((void) (lock), (void) (flags))
+
+#define smp_wmb() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define smp_store_release(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+#endif
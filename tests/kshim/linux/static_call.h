@@ -0,0 +1,9 @@
+#ifndef KSHIM_LINUX_STATIC_CALL_H
+#define KSHIM_LINUX_STATIC_CALL_H
+
+// No code patching in userspace, a static call is a plain function pointer
+#define DEFINE_STATIC_CALL(name, func) __typeof__(func) *kshim_static_call_##name = func
+#define static_call(name) (kshim_static_call_##name)
+#define static_call_update(name, func) (kshim_static_call_##name = (func))
+
+#endif
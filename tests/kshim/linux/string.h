@@ -0,0 +1,17 @@
+#ifndef KSHIM_LINUX_STRING_H
+#define KSHIM_LINUX_STRING_H
+
+#include <linux/kernel.h>
+
+static inline long strscpy(char *dest, const char *src, size_t count) {
+    size_t len = strnlen(src, count);
+    if (len == count) {
+        memcpy(dest, src, count - 1);
+        dest[count - 1] = '\0';
+        return -E2BIG;
+    }
+    memcpy(dest, src, len + 1);
+    return (long) len;
+}
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef KSHIM_LINUX_TIME_H
+#define KSHIM_LINUX_TIME_H
+
+#include <linux/ktime.h>
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef KSHIM_LINUX_TRACEPOINT_H
+#define KSHIM_LINUX_TRACEPOINT_H
+
+#include <linux/types.h>
+
+// No tracing in userspace, every event is permanently off
+#define TP_PROTO(...) __VA_ARGS__
+#define TP_ARGS(...) __VA_ARGS__
+#define TRACE_EVENT(name, proto, args, tstruct, assign, print) \
+    static inline void trace_##name(proto) { }
+
+#endif
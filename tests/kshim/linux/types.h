@@ -0,0 +1,27 @@
+#ifndef KSHIM_LINUX_TYPES_H
+#define KSHIM_LINUX_TYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <limits.h>
+#include <assert.h> // static_assert, the kernel gets it through build_bug.h
+
+typedef int8_t s8;
+typedef uint8_t u8;
+typedef int16_t s16;
+typedef uint16_t u16;
+typedef int32_t s32;
+typedef uint32_t u32;
+typedef long long s64;
+typedef unsigned long long u64;
+
+typedef s64 ktime_t;
+
+typedef u8 __u8;
+typedef s32 __s32;
+typedef u32 __u32;
+typedef s64 __s64;
+typedef u64 __u64;
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef KSHIM_LINUX_UACCESS_H
+#define KSHIM_LINUX_UACCESS_H
+
+#include <linux/kernel.h>
+
+// There's no separate user address space, the copies always succeed
+#define __user
+
+static inline unsigned long copy_from_user(void *to, const void __user *from, unsigned long n) { memcpy(to, from, n); return 0; }
+static inline unsigned long copy_to_user(void __user *to, const void *from, unsigned long n) { memcpy(to, from, n); return 0; }
+#define get_user(x, ptr) ({ (x) = *(ptr); 0; })
+#define put_user(x, ptr) ({ *(ptr) = (x); 0; })
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef KSHIM_LINUX_USB_INPUT_H
+#define KSHIM_LINUX_USB_INPUT_H
+
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+
+#define EV_SYN 0x00
+#define EV_KEY 0x01
+#define EV_REL 0x02
+#define EV_MSC 0x04
+
+#define SYN_REPORT 0
+
+#define REL_X 0x00
+#define REL_Y 0x01
+#define REL_HWHEEL 0x06
+#define REL_WHEEL 0x08
+
+#define MSC_TIMESTAMP 0x05
+
+#define BTN_MOUSE 0x110
+#define BTN_LEFT 0x110
+
+#define INPUT_DEVICE_ID_MATCH_EVBIT 0x0001
+
+#define BITS_PER_LONG (sizeof(long) * 8)
+#define BIT_MASK(nr) (1UL << ((nr) % BITS_PER_LONG))
+
+static inline bool test_bit(unsigned int nr, const unsigned long *addr) {
+    return (addr[nr / BITS_PER_LONG] >> (nr % BITS_PER_LONG)) & 1;
+}
+
+struct list_head { struct list_head *next, *prev; };
+
+#define list_add_rcu(entry, head) ((void) (entry), (void) (head))
+#define list_add_tail_rcu(entry, head) ((void) (entry), (void) (head))
+
+struct input_value {
+    u16 type;
+    u16 code;
+    s32 value;
+};
+
+enum input_clock_type {
+    INPUT_CLK_REAL = 0,
+    INPUT_CLK_MONO,
+    INPUT_CLK_BOOT,
+    INPUT_CLK_MAX
+};
+
+struct device {
+    struct device *parent;
+    const char *init_name;
+};
+
+struct input_handle;
+
+struct input_dev {
+    const char *name;
+    const char *phys;
+    struct device dev;
+    unsigned long evbit[1];
+    unsigned long keybit[(BTN_MOUSE + BITS_PER_LONG) / BITS_PER_LONG];
+    unsigned long relbit[1];
+    unsigned int num_vals;
+    ktime_t timestamp[INPUT_CLK_MAX];
+    struct mutex mutex;
+    struct list_head h_list;
+
+    struct input_handle *kshim_handle; // Handle opened on this device by input_open_device()
+};
+
+struct input_device_id {
+    unsigned long flags;
+    unsigned long evbit[1];
+};
+
+struct input_handler;
+
+struct input_handle {
+    void *private;
+    const char *name;
+    struct input_dev *dev;
+    struct input_handler *handler;
+    unsigned int (*handle_events)(struct input_handle *handle, struct input_value *vals, unsigned int count);
+    struct list_head d_node;
+    struct list_head h_node;
+};
+
+struct input_handler {
+    const char *name;
+    const struct input_device_id *id_table;
+    unsigned int (*events)(struct input_handle *handle, struct input_value *vals, unsigned int count);
+    int (*connect)(struct input_handler *handler, struct input_dev *dev, const struct input_device_id *id);
+    void (*disconnect)(struct input_handle *handle);
+    bool (*match)(struct input_handler *handler, struct input_dev *dev);
+    void (*start)(struct input_handle *handle);
+    struct list_head h_list;
+};
+
+static inline ktime_t *input_get_timestamp(struct input_dev *dev) {
+    return dev->timestamp;
+}
+
+static inline const char *dev_name(const struct device *dev) {
+    return dev->init_name ? dev->init_name : "kshim";
+}
+
+static inline struct input_dev *input_get_device(struct input_dev *dev) { return dev; }
+
+static inline int input_open_device(struct input_handle *handle) {
+    handle->dev->kshim_handle = handle;
+    return 0;
+}
+
+static inline void input_close_device(struct input_handle *handle) {
+    handle->dev->kshim_handle = NULL;
+}
+
+static inline void input_unregister_handle(struct input_handle *handle) { (void) handle; }
+static inline int input_register_handler(struct input_handler *handler) { (void) handler; return 0; }
+static inline void input_unregister_handler(struct input_handler *handler) { (void) handler; }
+
+#endif
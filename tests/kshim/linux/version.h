@@ -0,0 +1,11 @@
+#ifndef KSHIM_LINUX_VERSION_H
+#define KSHIM_LINUX_VERSION_H
+
+#define KERNEL_VERSION(a, b, c) (((a) << 16) + ((b) << 8) + ((c) > 255 ? 255 : (c)))
+
+// Newest input core API (handlers return the number of events left)
+#ifndef LINUX_VERSION_CODE
+#define LINUX_VERSION_CODE KERNEL_VERSION(6, 12, 0)
+#endif
+
+#endif
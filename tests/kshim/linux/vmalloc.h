@@ -0,0 +1,9 @@
+#ifndef KSHIM_LINUX_VMALLOC_H
+#define KSHIM_LINUX_VMALLOC_H
+
+#include <linux/slab.h>
+
+static inline void *vmalloc_user(unsigned long size) { return kzalloc(size, GFP_KERNEL); }
+static inline void vfree(const void *p) { kfree(p); }
+
+#endif
@@ -0,0 +1 @@
+// The trace header is only ever read once in userspace, there is nothing to define
@@ -17,6 +17,26 @@ int main() {
         }
     }
 
+    if (!Tests::TestCurveTable()) {
+        fprintf(stderr, "Test failed for the compiled curve\n");
+        bad_sum++;
+    }
+
+    if (!Tests::TestAngleSnapping()) {
+        fprintf(stderr, "Test failed for angle snapping\n");
+        bad_sum++;
+    }
+
+    if (!Tests::TestFixedPointArithmetic()) {
+        fprintf(stderr, "Test failed for the fixed-point arithmetic\n");
+        bad_sum++;
+    }
+
+    if (!Tests::TestLutText()) {
+        fprintf(stderr, "Test failed for the LUT text\n");
+        bad_sum++;
+    }
+
     if (bad_sum == 0) {
         printf(GREEN"All tests passed!\n" RESET);
     }
@@ -24,7 +44,5 @@ int main() {
         printf(RED"%i %s failed!\n", bad_sum, (bad_sum == 1) ? "test" : "tests");
     }
 
-    // Tests::TestFixedPointArithmetic();
-
     return 0;
 }
\ No newline at end of file